@@ -0,0 +1,116 @@
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/ioctl.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+
+#include "ds3231_lib.h"
+
+/* i2c-dev start */
+
+static int i2cdev_read(void *ctx, unsigned int reg, unsigned char *buf, unsigned int len)
+{
+    unsigned char addr = reg;
+    struct i2c_msg msgs[2] = {
+        { .addr = DS3231_I2C_ADDR, .flags = 0, .len = 1, .buf = &addr },
+        { .addr = DS3231_I2C_ADDR, .flags = I2C_M_RD, .len = len, .buf = buf },
+    };
+    struct i2c_rdwr_ioctl_data data = { .msgs = msgs, .nmsgs = 2 };
+
+    return ioctl((int)(intptr_t)ctx, I2C_RDWR, &data) < 0 ? -errno : 0;
+}
+
+static int i2cdev_write(void *ctx, unsigned int reg, const unsigned char *buf, unsigned int len)
+{
+    unsigned char out[RTC_NR_REGS + 1];
+    struct i2c_msg msg = { .addr = DS3231_I2C_ADDR, .flags = 0, .len = len + 1, .buf = out };
+    struct i2c_rdwr_ioctl_data data = { .msgs = &msg, .nmsgs = 1 };
+
+    if (len > RTC_NR_REGS)
+        return -EINVAL;
+    out[0] = reg;
+    memcpy(&out[1], buf, len);
+    return ioctl((int)(intptr_t)ctx, I2C_RDWR, &data) < 0 ? -errno : 0;
+}
+
+int ds3231_i2cdev_open(struct ds3231_transport *tr, const char *path)
+{
+    int fd = open(path, O_RDWR);
+
+    if (fd < 0)
+        return -errno;
+    tr->read = i2cdev_read;
+    tr->write = i2cdev_write;
+    tr->ctx = (void *)(intptr_t)fd;
+    return 0;
+}
+
+void ds3231_i2cdev_close(struct ds3231_transport *tr)
+{
+    close((int)(intptr_t)tr->ctx);
+}
+
+/* i2c-dev end */
+
+/* mock start */
+
+static int mock_read(void *ctx, unsigned int reg, unsigned char *buf, unsigned int len)
+{
+    struct ds3231_mock *mock = ctx;
+
+    if (reg + len > RTC_NR_REGS)
+        return -EINVAL;
+    if (mock->fail)
+        return -EIO;
+    memcpy(buf, &mock->regs[reg], len);
+    mock->xfers += 2;
+    mock->bytes += 1 + len;
+    return 0;
+}
+
+static int mock_write(void *ctx, unsigned int reg, const unsigned char *buf, unsigned int len)
+{
+    struct ds3231_mock *mock = ctx;
+    unsigned int i;
+
+    if (reg + len > RTC_NR_REGS)
+        return -EINVAL;
+    if (mock->fail)
+        return -EIO;
+    for (i = 0; i < len; i++) {
+        unsigned int r = reg + i;
+
+        if (r == RTC_STAT_REG_ADDR) {
+            // OSF, A2F and A1F are only cleared by writes, BSY is read-only
+            unsigned char flags = RTC_STAT_BIT_OSF | RTC_STAT_BIT_A2F | RTC_STAT_BIT_A1F;
+
+            mock->regs[r] = (mock->regs[r] & buf[i] & flags) | (buf[i] & 0x08);
+        } else if (r != RTC_TEMP_MSB_REG_ADDR && r != RTC_TEMP_LSB_REG_ADDR) {
+            mock->regs[r] = buf[i];
+        }
+    }
+    mock->xfers++;
+    mock->bytes += 1 + len;
+    return 0;
+}
+
+// Power-on state: 2000-01-01 00:00:00, a Saturday, oscillator stop flagged, 25 C
+void ds3231_mock_init(struct ds3231_mock *mock, struct ds3231_transport *tr)
+{
+    memset(mock, 0, sizeof(*mock));
+    mock->regs[RTC_DAY_REG_ADDR] = 0x07;
+    mock->regs[RTC_DATE_REG_ADDR] = 0x01;
+    mock->regs[RTC_MON_REG_ADDR] = 0x01;
+    mock->regs[RTC_CTL_REG_ADDR] = RTC_CTL_BIT_INTCN | RTC_CTL_BIT_RS1 | RTC_CTL_BIT_RS2;
+    mock->regs[RTC_STAT_REG_ADDR] = RTC_STAT_BIT_OSF | 0x08;
+    mock->regs[RTC_TEMP_MSB_REG_ADDR] = 25;
+
+    tr->read = mock_read;
+    tr->write = mock_write;
+    tr->ctx = mock;
+}
+
+/* mock end */
@@ -0,0 +1,25 @@
+// Userspace transports for the DS3231 core: the chip behind /dev/i2c-N, or an in-memory mock
+#ifndef DS3231_LIB_H
+#define DS3231_LIB_H
+
+#include "../ds3231_core.h"
+
+#define DS3231_I2C_ADDR     (0x68)
+
+// Open an i2c-dev adapter, e.g. "/dev/i2c-2". Register accesses are combined I2C_RDWR
+// transfers, so this works whether or not the driver is bound to the chip, but does not take
+// the driver's bus lock: only use it for diagnostics while the module is loaded.
+int ds3231_i2cdev_open(struct ds3231_transport *tr, const char *path);
+void ds3231_i2cdev_close(struct ds3231_transport *tr);
+
+// Register file that behaves like the chip for the core sequences. The clock does not run,
+// status flags can only be cleared and the temperature is read-only.
+struct ds3231_mock {
+    unsigned char regs[RTC_NR_REGS];
+    unsigned long xfers, bytes;     // Transfers and bytes on the wire, register address included
+    bool fail;                      // Every access fails with -EIO, like a stuck bus
+};
+
+void ds3231_mock_init(struct ds3231_mock *mock, struct ds3231_transport *tr);
+
+#endif
@@ -0,0 +1,750 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "ds3231_lib.h"
+
+// Unit tests of the register core against the mock. Every check that fails is printed and the
+// run exits with a failure status.
+
+static unsigned int checks, failures;
+
+#define CHECK(cond) do {                                                    \
+        checks++;                                                           \
+        if (!(cond)) {                                                      \
+            failures++;                                                     \
+            fprintf(stderr, "%s:%d: %s: check failed: %s\n",                \
+                    __FILE__, __LINE__, __func__, #cond);                   \
+        }                                                                   \
+    } while (0)
+
+#define CHECK_EQ(a, b) do {                                                 \
+        long long _a = (a), _b = (b);                                       \
+        checks++;                                                           \
+        if (_a != _b) {                                                     \
+            failures++;                                                     \
+            fprintf(stderr, "%s:%d: %s: %s == %lld, expected %lld\n",        \
+                    __FILE__, __LINE__, __func__, #a, _a, _b);              \
+        }                                                                   \
+    } while (0)
+
+#define CHECK_REGS(regs, ...) do {                                          \
+        const unsigned char _want[] = { __VA_ARGS__ };                      \
+        checks++;                                                           \
+        if (memcmp((regs), _want, sizeof(_want))) {                         \
+            failures++;                                                     \
+            fprintf(stderr, "%s:%d: %s: %s differ from %s\n",                \
+                    __FILE__, __LINE__, __func__, #regs, #__VA_ARGS__);     \
+        }                                                                   \
+    } while (0)
+
+static const struct ds3231_time tm_leap = {
+    .sec = 59, .min = 59, .hour = 23, .day = 5, .date = 29, .month = 2, .year = 24,
+};
+
+static void set_mock_time(struct ds3231_mock *mock, unsigned int year, unsigned int month,
+                          unsigned int date, unsigned int hour, unsigned int min, unsigned int sec)
+{
+    struct ds3231_time tm = { .sec = sec, .min = min, .hour = hour, .date = date,
+                              .month = month, .year = year };
+
+    // The day of the week comes from the date
+    ds3231_time_to_tm(ds3231_mktime(&tm), &tm);
+    ds3231_encode_time(&tm, &mock->regs[RTC_SEC_REG_ADDR]);
+}
+
+/* mock start */
+
+// The tests below rely on the mock behaving like the chip
+static void test_mock(void)
+{
+    struct ds3231_transport tr;
+    struct ds3231_mock mock;
+    unsigned char buf[RTC_NR_REGS], val;
+
+    // Power-on state: 2000-01-01 00:00:00, a Saturday, oscillator stop flagged, 25 C
+    ds3231_mock_init(&mock, &tr);
+    CHECK_EQ(tr.read(tr.ctx, 0, buf, RTC_NR_REGS), 0);
+    CHECK_REGS(buf, 0x00, 0x00, 0x00, 0x07, 0x01, 0x01, 0x00);
+    CHECK_EQ(buf[RTC_CTL_REG_ADDR], RTC_CTL_BIT_INTCN | RTC_CTL_BIT_RS1 | RTC_CTL_BIT_RS2);
+    CHECK_EQ(buf[RTC_STAT_REG_ADDR], RTC_STAT_BIT_OSF | 0x08);
+    CHECK_EQ(buf[RTC_TEMP_MSB_REG_ADDR], 25);
+
+    // A read is a write/read pair, the register address goes on the wire too
+    CHECK_EQ(mock.xfers, 2);
+    CHECK_EQ(mock.bytes, 1 + RTC_NR_REGS);
+
+    // Status flags can only be cleared, EN32kHz is written as is and BSY is read-only
+    mock.regs[RTC_STAT_REG_ADDR] = RTC_STAT_BIT_OSF;
+    val = RTC_STAT_BIT_A1F | RTC_STAT_BIT_A2F | RTC_STAT_BIT_OSF;
+    CHECK_EQ(tr.write(tr.ctx, RTC_STAT_REG_ADDR, &val, 1), 0);
+    CHECK_EQ(mock.regs[RTC_STAT_REG_ADDR], RTC_STAT_BIT_OSF);
+    val = 0x08 | 0x04;
+    CHECK_EQ(tr.write(tr.ctx, RTC_STAT_REG_ADDR, &val, 1), 0);
+    CHECK_EQ(mock.regs[RTC_STAT_REG_ADDR], 0x08);
+    CHECK_EQ(mock.xfers, 4);
+    CHECK_EQ(mock.bytes, 1 + RTC_NR_REGS + 4);
+
+    // The temperature is read-only, the registers around it are not
+    buf[0] = 0x55;
+    buf[1] = 0x66;
+    buf[2] = 0x77;
+    CHECK_EQ(tr.write(tr.ctx, RTC_AGING_REG_ADDR, buf, 3), 0);
+    CHECK_EQ(mock.regs[RTC_AGING_REG_ADDR], 0x55);
+    CHECK_EQ(mock.regs[RTC_TEMP_MSB_REG_ADDR], 25);
+    CHECK_EQ(mock.regs[RTC_TEMP_LSB_REG_ADDR], 0);
+
+    // Nothing past the register file
+    CHECK_EQ(tr.read(tr.ctx, RTC_TEMP_LSB_REG_ADDR, buf, 2), -EINVAL);
+    CHECK_EQ(tr.write(tr.ctx, RTC_NR_REGS, buf, 1), -EINVAL);
+    CHECK_EQ(mock.xfers, 5);
+}
+
+/* mock end */
+
+/* encoding start */
+
+static void test_bcd(void)
+{
+    unsigned int i;
+
+    for (i = 0; i < 100; i++) {
+        CHECK_EQ(ds3231_bin2bcd(i), (i / 10) * 16 + i % 10);
+        CHECK_EQ(ds3231_bcd2bin(ds3231_bin2bcd(i)), i);
+    }
+    CHECK_EQ(ds3231_bin2bcd(59), 0x59);
+    CHECK_EQ(ds3231_bcd2bin(0x99), 99);
+}
+
+static void test_time_encoding(void)
+{
+    unsigned char regs[7];
+    struct ds3231_time tm;
+
+    ds3231_encode_time(&tm_leap, regs);
+    CHECK_REGS(regs, 0x59, 0x59, 0x23, 0x05, 0x29, 0x02, 0x24);
+
+    // Oscillator stop flag in the seconds register, century bit in the month register
+    regs[RTC_SEC_REG_ADDR] |= 0x80;
+    regs[RTC_MON_REG_ADDR] |= 0x80;
+    ds3231_decode_time(regs, &tm);
+    CHECK(!memcmp(&tm, &tm_leap, sizeof(tm)));
+}
+
+static void test_time_rollover(void)
+{
+    struct ds3231_time tm = tm_leap;
+    int64_t t;
+
+    // 2000-01-01 00:00:00 was a Saturday
+    tm = (struct ds3231_time){ .date = 1, .month = 1, .year = 0 };
+    t = ds3231_mktime(&tm);
+    CHECK_EQ(t, 946684800);
+    ds3231_time_to_tm(t, &tm);
+    CHECK_EQ(tm.day, 7);
+
+    // Leap day in a leap year, and in 2000, which is divisible by 400
+    tm = (struct ds3231_time){ .sec = 59, .min = 59, .hour = 23, .date = 28, .month = 2, .year = 24 };
+    ds3231_time_to_tm(ds3231_mktime(&tm) + 1, &tm);
+    CHECK_EQ(tm.month, 2);
+    CHECK_EQ(tm.date, 29);
+    CHECK_EQ(tm.hour, 0);
+    CHECK_EQ(tm.day, 5);
+
+    tm = (struct ds3231_time){ .date = 28, .month = 2, .year = 0 };
+    ds3231_time_to_tm(ds3231_mktime(&tm) + 86400, &tm);
+    CHECK_EQ(tm.month, 2);
+    CHECK_EQ(tm.date, 29);
+
+    // No leap day in a common year
+    tm = (struct ds3231_time){ .sec = 59, .min = 59, .hour = 23, .date = 28, .month = 2, .year = 23 };
+    ds3231_time_to_tm(ds3231_mktime(&tm) + 1, &tm);
+    CHECK_EQ(tm.month, 3);
+    CHECK_EQ(tm.date, 1);
+
+    // Year rollover, 2024-01-01 was a Monday
+    tm = (struct ds3231_time){ .sec = 59, .min = 59, .hour = 23, .date = 31, .month = 12, .year = 23 };
+    ds3231_time_to_tm(ds3231_mktime(&tm) + 1, &tm);
+    CHECK_EQ(tm.year, 24);
+    CHECK_EQ(tm.month, 1);
+    CHECK_EQ(tm.date, 1);
+    CHECK_EQ(tm.hour, 0);
+    CHECK_EQ(tm.min, 0);
+    CHECK_EQ(tm.sec, 0);
+    CHECK_EQ(tm.day, 2);
+
+    // Last second the RTC keeps
+    tm = (struct ds3231_time){ .sec = 59, .min = 59, .hour = 23, .date = 31, .month = 12, .year = 99 };
+    t = ds3231_mktime(&tm);
+    ds3231_time_to_tm(t, &tm);
+    CHECK_EQ(tm.year, 99);
+    CHECK_EQ(tm.month, 12);
+    CHECK_EQ(tm.date, 31);
+    CHECK_EQ(tm.sec, 59);
+    ds3231_time_to_tm(t + 1, &tm);
+    CHECK_EQ(tm.year, 100);
+}
+
+static void test_temp(void)
+{
+    const unsigned char t25_25[2] = { 0x19, 0x40 }, tm25[2] = { 0xE7, 0x00 }, tm0_25[2] = { 0xFF, 0xC0 };
+
+    CHECK_EQ(ds3231_decode_temp(t25_25), 101);
+    CHECK_EQ(ds3231_decode_temp(tm25), -100);
+    CHECK_EQ(ds3231_decode_temp(tm0_25), -1);
+}
+
+static void test_alarm_encoding(void)
+{
+    unsigned char alarm[4];
+    unsigned int mode, day, hour, min, sec;
+
+    CHECK_EQ(ds3231_encode_alarm1(DS3231_ALM_EVERY_SECOND, 0, 0, 0, 0, alarm), 0);
+    CHECK_REGS(alarm, 0x80, 0x80, 0x80, 0x81);
+    CHECK_EQ(ds3231_encode_alarm1(DS3231_ALM_MATCH_SEC, 0, 0, 0, 30, alarm), 0);
+    CHECK_REGS(alarm, 0x30, 0x80, 0x80, 0x81);
+    CHECK_EQ(ds3231_encode_alarm1(DS3231_ALM_MATCH_MIN_SEC, 0, 0, 45, 30, alarm), 0);
+    CHECK_REGS(alarm, 0x30, 0x45, 0x80, 0x81);
+    CHECK_EQ(ds3231_encode_alarm1(DS3231_ALM_MATCH_HMS, 0, 23, 59, 59, alarm), 0);
+    CHECK_REGS(alarm, 0x59, 0x59, 0x23, 0x81);
+    CHECK_EQ(ds3231_encode_alarm1(DS3231_ALM_MATCH_DATE, 31, 12, 34, 56, alarm), 0);
+    CHECK_REGS(alarm, 0x56, 0x34, 0x12, 0x31);
+    CHECK_EQ(ds3231_encode_alarm1(DS3231_ALM_MATCH_DAY, 7, 6, 5, 4, alarm), 0);
+    CHECK_REGS(alarm, 0x04, 0x05, 0x06, 0x47);
+
+    // Out of range fields are only rejected where the mode matches them
+    CHECK_EQ(ds3231_encode_alarm1(DS3231_ALM_MATCH_SEC, 0, 24, 60, 59, alarm), 0);
+    CHECK_EQ(ds3231_encode_alarm1(DS3231_ALM_MATCH_SEC, 0, 0, 0, 60, alarm), -EINVAL);
+    CHECK_EQ(ds3231_encode_alarm1(DS3231_ALM_MATCH_HMS, 0, 24, 0, 0, alarm), -EINVAL);
+    CHECK_EQ(ds3231_encode_alarm1(DS3231_ALM_MATCH_DATE, 0, 0, 0, 0, alarm), -EINVAL);
+    CHECK_EQ(ds3231_encode_alarm1(DS3231_ALM_MATCH_DATE, 32, 0, 0, 0, alarm), -EINVAL);
+    CHECK_EQ(ds3231_encode_alarm1(DS3231_ALM_MATCH_DAY, 8, 0, 0, 0, alarm), -EINVAL);
+    CHECK_EQ(ds3231_encode_alarm1(DS3231_ALM_MODE_MAX, 1, 0, 0, 0, alarm), -EINVAL);
+
+    // Every mode decodes to itself
+    for (mode = 0; mode < DS3231_ALM_MODE_MAX; mode++) {
+        CHECK_EQ(ds3231_encode_alarm1(mode, 5, 13, 14, 15, alarm), 0);
+        CHECK_EQ(ds3231_decode_alarm1(alarm, &day, &hour, &min, &sec), mode);
+        if (mode >= DS3231_ALM_MATCH_DATE)
+            CHECK_EQ(day, 5);
+        if (mode >= DS3231_ALM_MATCH_HMS)
+            CHECK_EQ(hour, 13);
+        if (mode >= DS3231_ALM_MATCH_MIN_SEC)
+            CHECK_EQ(min, 14);
+        if (mode >= DS3231_ALM_MATCH_SEC)
+            CHECK_EQ(sec, 15);
+    }
+
+    // A1M1 set with A1M2 clear is not a mode of the chip
+    memcpy(alarm, (unsigned char[4]){ 0x80, 0x00, 0x80, 0x80 }, 4);
+    CHECK_EQ(ds3231_decode_alarm1(alarm, &day, &hour, &min, &sec), -EINVAL);
+    // DY/DT is ignored while A1M4 is set
+    memcpy(alarm, (unsigned char[4]){ 0x10, 0x20, 0x08, 0xC1 }, 4);
+    CHECK_EQ(ds3231_decode_alarm1(alarm, &day, &hour, &min, &sec), DS3231_ALM_MATCH_HMS);
+}
+
+static void test_alarm_plan(void)
+{
+    struct ds3231_time tm = { .hour = 12, .date = 10, .month = 2, .year = 24 };
+    int64_t now = ds3231_mktime(&tm);
+    unsigned char alarm[4];
+
+    CHECK_EQ(ds3231_plan_alarm1_abs(now, now, alarm), -EINVAL);
+    CHECK_EQ(ds3231_plan_alarm1_abs(now, now - 1, alarm), -EINVAL);
+
+    // Less than a day: time match, also across midnight
+    CHECK_EQ(ds3231_plan_alarm1_abs(now, now + 12 * 3600 + 5, alarm), 0);
+    CHECK_REGS(alarm, 0x05, 0x00, 0x00, 0x81);
+
+    // Later this month: date match, up to the last day of a leap February
+    CHECK_EQ(ds3231_plan_alarm1_abs(now, now + 25 * 3600, alarm), 0);
+    CHECK_REGS(alarm, 0x00, 0x00, 0x13, 0x11);
+    CHECK_EQ(ds3231_plan_alarm1_abs(now, now + 19 * 86400, alarm), 0);
+    CHECK_REGS(alarm, 0x00, 0x00, 0x12, 0x29);
+
+    // Next month: intermediate alarm at midnight on the 1st
+    CHECK_EQ(ds3231_plan_alarm1_abs(now, now + 20 * 86400, alarm), 1);
+    CHECK_REGS(alarm, 0x00, 0x00, 0x00, 0x01);
+
+    // 2100-01-01 is beyond what the RTC keeps
+    tm = (struct ds3231_time){ .sec = 59, .min = 59, .hour = 23, .date = 31, .month = 12, .year = 99 };
+    CHECK_EQ(ds3231_plan_alarm1_abs(now, ds3231_mktime(&tm), alarm), 1);
+    CHECK_EQ(ds3231_plan_alarm1_abs(now, ds3231_mktime(&tm) + 1, alarm), -EINVAL);
+}
+
+/* encoding end */
+
+/* register sequences start */
+
+static void test_init_chip(void)
+{
+    struct ds3231_transport tr;
+    struct ds3231_mock mock;
+
+    ds3231_mock_init(&mock, &tr);
+    mock.regs[RTC_SEC_REG_ADDR] = 0x80 | 0x42;
+    mock.regs[RTC_CTL_REG_ADDR] = RTC_CTL_BIT_A1IE | RTC_CTL_BIT_A2IE;
+    mock.regs[RTC_STAT_REG_ADDR] |= RTC_STAT_BIT_A1F;
+
+    CHECK_EQ(ds3231_init_chip(&tr), 0);
+    CHECK_EQ(mock.regs[RTC_SEC_REG_ADDR], 0x42);
+    CHECK_EQ(mock.regs[RTC_CTL_REG_ADDR], RTC_CTL_BIT_INTCN | RTC_CTL_BIT_RS1 | RTC_CTL_BIT_RS2);
+    CHECK_EQ(mock.regs[RTC_STAT_REG_ADDR] & (RTC_STAT_BIT_OSF | RTC_STAT_BIT_A1F), 0);
+}
+
+static void test_set_get_time(void)
+{
+    struct ds3231_transport tr;
+    struct ds3231_mock mock;
+    struct ds3231_time tm;
+    unsigned int i;
+    static const struct ds3231_time bad[] = {
+        { .sec = 60, .day = 1, .date = 1, .month = 1 },
+        { .min = 60, .day = 1, .date = 1, .month = 1 },
+        { .hour = 24, .day = 1, .date = 1, .month = 1 },
+        { .day = 0, .date = 1, .month = 1 },
+        { .day = 8, .date = 1, .month = 1 },
+        { .day = 1, .date = 0, .month = 1 },
+        { .day = 1, .date = 32, .month = 1 },
+        { .day = 1, .date = 1, .month = 0 },
+        { .day = 1, .date = 1, .month = 13 },
+        { .day = 1, .date = 1, .month = 1, .year = 100 },
+    };
+
+    ds3231_mock_init(&mock, &tr);
+    CHECK_EQ(ds3231_set_time(&tr, &tm_leap), 0);
+    CHECK_REGS(mock.regs, 0x59, 0x59, 0x23, 0x05, 0x29, 0x02, 0x24);
+    // Time and date go in one transaction
+    CHECK_EQ(mock.xfers, 1);
+    CHECK_EQ(mock.bytes, 8);
+
+    memset(&tm, 0xff, sizeof(tm));
+    CHECK_EQ(ds3231_get_time(&tr, &tm), 0);
+    CHECK(!memcmp(&tm, &tm_leap, sizeof(tm)));
+
+    // Invalid times are rejected before anything goes on the bus
+    for (i = 0; i < sizeof(bad) / sizeof(bad[0]); i++)
+        CHECK_EQ(ds3231_set_time(&tr, &bad[i]), -EINVAL);
+    CHECK_EQ(mock.xfers, 3);
+    CHECK_REGS(mock.regs, 0x59, 0x59, 0x23, 0x05, 0x29, 0x02, 0x24);
+}
+
+static void test_get_status(void)
+{
+    struct ds3231_transport tr;
+    struct ds3231_mock mock;
+    struct ds3231_status st;
+
+    ds3231_mock_init(&mock, &tr);
+    mock.regs[RTC_TEMP_MSB_REG_ADDR] = 0x19;
+    mock.regs[RTC_TEMP_LSB_REG_ADDR] = 0x40;
+    CHECK_EQ(ds3231_get_status(&tr, &st), 0);
+    CHECK_EQ(st.ctl, RTC_CTL_BIT_INTCN | RTC_CTL_BIT_RS1 | RTC_CTL_BIT_RS2);
+    CHECK_EQ(st.status & RTC_STAT_BIT_OSF, RTC_STAT_BIT_OSF);
+    CHECK_EQ(st.temp_qc, 101);
+    // Control to temperature in one read
+    CHECK_EQ(mock.xfers, 2);
+}
+
+static void test_set_alarm1(void)
+{
+    struct ds3231_transport tr;
+    struct ds3231_mock mock;
+    unsigned char alarm[4];
+
+    ds3231_mock_init(&mock, &tr);
+    mock.regs[RTC_STAT_REG_ADDR] |= RTC_STAT_BIT_A1F;
+    ds3231_encode_alarm1(DS3231_ALM_MATCH_HMS, 0, 7, 8, 9, alarm);
+
+    CHECK_EQ(ds3231_set_alarm1(&tr, alarm), 0);
+    CHECK_REGS(&mock.regs[RTC_ALM1_REG_ADDR], 0x09, 0x08, 0x07, 0x81);
+    CHECK_EQ(mock.regs[RTC_CTL_REG_ADDR], RTC_CTL_BIT_INTCN | RTC_CTL_BIT_RS1 | RTC_CTL_BIT_RS2 | RTC_CTL_BIT_A1IE);
+    CHECK_EQ(mock.regs[RTC_STAT_REG_ADDR] & RTC_STAT_BIT_A1F, 0);
+    // OSF is not cleared along with A1F
+    CHECK_EQ(mock.regs[RTC_STAT_REG_ADDR] & RTC_STAT_BIT_OSF, RTC_STAT_BIT_OSF);
+
+    // Nothing to enable or clear the second time, only the alarm registers are written
+    mock.xfers = 0;
+    CHECK_EQ(ds3231_set_alarm1(&tr, alarm), 0);
+    CHECK_EQ(mock.xfers, 3);
+
+    // With the square wave on the pin, INTCN stays clear
+    mock.regs[RTC_CTL_REG_ADDR] = RTC_CTL_BIT_RS1;
+    CHECK_EQ(ds3231_set_alarm1(&tr, alarm), 0);
+    CHECK_EQ(mock.regs[RTC_CTL_REG_ADDR], RTC_CTL_BIT_RS1 | RTC_CTL_BIT_A1IE);
+}
+
+static void test_set_alarm1_after(void)
+{
+    struct ds3231_transport tr;
+    struct ds3231_mock mock;
+    int64_t target, now;
+
+    ds3231_mock_init(&mock, &tr);
+
+    // Wraps past midnight, and past the end of the year
+    set_mock_time(&mock, 23, 12, 31, 23, 59, 50);
+    CHECK_EQ(ds3231_set_alarm1_after(&tr, 0, 0, 15, &target), 0);
+    CHECK_EQ(target, 0);
+    CHECK_REGS(&mock.regs[RTC_ALM1_REG_ADDR], 0x05, 0x00, 0x00, 0x81);
+
+    set_mock_time(&mock, 24, 2, 28, 23, 59, 59);
+    CHECK_EQ(ds3231_set_alarm1_after(&tr, 0, 0, 1, &target), 0);
+    CHECK_REGS(&mock.regs[RTC_ALM1_REG_ADDR], 0x00, 0x00, 0x00, 0x81);
+
+    // Minutes and seconds carry into hours
+    set_mock_time(&mock, 24, 2, 10, 10, 30, 30);
+    CHECK_EQ(ds3231_set_alarm1_after(&tr, 1, 45, 40, &target), 0);
+    CHECK_REGS(&mock.regs[RTC_ALM1_REG_ADDR], 0x10, 0x16, 0x12, 0x81);
+    CHECK_EQ(mock.regs[RTC_CTL_REG_ADDR] & RTC_CTL_BIT_A1IE, RTC_CTL_BIT_A1IE);
+
+    // A day or more goes through the absolute alarm: date match in the same month
+    set_mock_time(&mock, 24, 2, 10, 12, 0, 0);
+    now = ds3231_regs_to_time(mock.regs);
+    CHECK_EQ(ds3231_set_alarm1_after(&tr, 25, 0, 0, &target), 0);
+    CHECK_EQ(target, now + 25 * 3600);
+    CHECK_REGS(&mock.regs[RTC_ALM1_REG_ADDR], 0x00, 0x00, 0x13, 0x11);
+
+    // and an intermediate alarm into the next month
+    set_mock_time(&mock, 23, 12, 31, 23, 59, 50);
+    now = ds3231_regs_to_time(mock.regs);
+    CHECK_EQ(ds3231_set_alarm1_after(&tr, 24, 0, 0, &target), 1);
+    CHECK_EQ(target, now + 24 * 3600);
+    CHECK_REGS(&mock.regs[RTC_ALM1_REG_ADDR], 0x00, 0x00, 0x00, 0x01);
+}
+
+static void test_arm_alarm1_abs(void)
+{
+    struct ds3231_transport tr;
+    struct ds3231_mock mock;
+    unsigned char alarm[4];
+    int64_t now;
+
+    ds3231_mock_init(&mock, &tr);
+    set_mock_time(&mock, 24, 2, 10, 12, 0, 0);
+    now = ds3231_regs_to_time(mock.regs);
+    ds3231_encode_alarm1(DS3231_ALM_MATCH_SEC, 0, 0, 0, 1, alarm);
+    memcpy(&mock.regs[RTC_ALM1_REG_ADDR], alarm, 4);
+
+    // Past targets leave the alarm alone
+    CHECK_EQ(ds3231_arm_alarm1_abs(&tr, now), -EINVAL);
+    CHECK_REGS(&mock.regs[RTC_ALM1_REG_ADDR], 0x01, 0x80, 0x80, 0x81);
+
+    CHECK_EQ(ds3231_arm_alarm1_abs(&tr, now + 90), 0);
+    CHECK_REGS(&mock.regs[RTC_ALM1_REG_ADDR], 0x30, 0x01, 0x12, 0x81);
+}
+
+static void test_set_sqw(void)
+{
+    struct ds3231_transport tr;
+    struct ds3231_mock mock;
+
+    ds3231_mock_init(&mock, &tr);
+    mock.regs[RTC_CTL_REG_ADDR] |= RTC_CTL_BIT_A1IE;
+
+    CHECK_EQ(ds3231_set_sqw(&tr, 8192), 0);
+    CHECK_EQ(mock.regs[RTC_CTL_REG_ADDR], RTC_CTL_BIT_RS1 | RTC_CTL_BIT_RS2 | RTC_CTL_BIT_A1IE);
+    CHECK_EQ(ds3231_set_sqw(&tr, 1024), 0);
+    CHECK_EQ(mock.regs[RTC_CTL_REG_ADDR], RTC_CTL_BIT_RS1 | RTC_CTL_BIT_A1IE);
+    CHECK_EQ(ds3231_set_sqw(&tr, 1), 0);
+    CHECK_EQ(mock.regs[RTC_CTL_REG_ADDR], RTC_CTL_BIT_A1IE);
+    CHECK_EQ(ds3231_set_sqw(&tr, 0), 0);
+    CHECK_EQ(mock.regs[RTC_CTL_REG_ADDR], RTC_CTL_BIT_INTCN | RTC_CTL_BIT_A1IE);
+
+    // No write when nothing changes, none at all for a rate the chip does not have
+    mock.xfers = 0;
+    CHECK_EQ(ds3231_set_sqw(&tr, 0), 0);
+    CHECK_EQ(mock.xfers, 2);
+    CHECK_EQ(ds3231_set_sqw(&tr, 2048), -EINVAL);
+    CHECK_EQ(mock.xfers, 2);
+}
+
+/* register sequences end */
+
+/* register cache start */
+
+static unsigned int pending_alm1(struct ds3231_cache *c)
+{
+    return RTC_ALM1_REGS;
+}
+
+// The cache the driver puts in front of the bus
+static void test_cache(void)
+{
+    struct ds3231_mock mock;
+    struct ds3231_transport bus;
+    struct ds3231_cache c;
+    struct ds3231_time tm;
+    unsigned char alarm[4];
+    unsigned long ticket;
+
+    ds3231_mock_init(&mock, &bus);
+    ds3231_cache_init(&c, &bus);
+    set_mock_time(&mock, 24, 2, 10, 12, 0, 0);
+
+    // One bulk read covers the read and what the operation announced, the rest is shared
+    ds3231_cache_begin(&c, DS3231_OP_DRIFT_SAMPLE, c.reads_started);
+    CHECK_EQ(ds3231_get_time(&c.tr, &tm), 0);
+    CHECK_EQ(tm.hour, 12);
+    CHECK_EQ(mock.xfers, 2);
+    CHECK_EQ(mock.bytes, 1 + RTC_NR_REGS);
+    CHECK_EQ(ds3231_get_alarm1(&c.tr, alarm), 0);
+    CHECK_EQ(mock.xfers, 2);
+    CHECK_EQ(c.bulk_reads, 1);
+    CHECK_EQ(c.coalesced, 1);
+    CHECK_EQ(c.cur.xfers, 2);
+    CHECK_EQ(c.cur.bytes, 1 + RTC_NR_REGS);
+
+    // An operation that arrived before that read shares it, one that arrives after does not
+    ds3231_cache_begin(&c, DS3231_OP_PROC_READ, c.reads_started - 1);
+    CHECK_EQ(ds3231_get_time(&c.tr, &tm), 0);
+    CHECK_EQ(mock.xfers, 2);
+    CHECK_EQ(c.cur.xfers, 0);
+    ds3231_cache_begin(&c, DS3231_OP_PROC_READ, c.reads_started);
+    CHECK_EQ(ds3231_get_time(&c.tr, &tm), 0);
+    CHECK_EQ(mock.xfers, 4);
+    CHECK_EQ(c.cur.bytes, 1 + 7);
+
+    // A write drops what it covers from the cache, even for an operation that may share
+    ticket = c.reads_started - 1;
+    ds3231_cache_begin(&c, DS3231_OP_IOCTL_WR_TIME, ticket);
+    CHECK_EQ(ds3231_set_time(&c.tr, &tm_leap), 0);
+    CHECK_EQ(c.cur.xfers, 1);
+    CHECK_EQ(c.cur.bytes, 1 + 7);
+    ds3231_cache_begin(&c, DS3231_OP_PROC_READ, ticket);
+    CHECK_EQ(ds3231_get_time(&c.tr, &tm), 0);
+    CHECK_EQ(tm.date, 29);
+    CHECK_EQ(c.cur.xfers, 2);
+
+    // Registers wanted by waiting operations are merged into the next bulk read
+    c.take_pending = pending_alm1;
+    ds3231_cache_begin(&c, DS3231_OP_PROC_READ, c.reads_started);
+    CHECK_EQ(ds3231_get_time(&c.tr, &tm), 0);
+    CHECK_EQ(c.cur.bytes, 1 + 11);
+    c.take_pending = NULL;
+
+    // Bus down: tr fails, tr_stale serves the last values read once per operation, if enabled
+    mock.fail = true;
+    mock.xfers = 0;
+    ds3231_cache_begin(&c, DS3231_OP_PROC_READ, c.reads_started);
+    CHECK_EQ(ds3231_get_time(&c.tr, &tm), -EIO);
+    CHECK_EQ(ds3231_get_time(&c.tr_stale, &tm), -EIO);
+    c.serve_stale = true;
+    memset(&tm, 0, sizeof(tm));
+    CHECK_EQ(ds3231_get_time(&c.tr_stale, &tm), DS3231_STALE);
+    CHECK_EQ(tm.date, 29);
+    CHECK_EQ(ds3231_get_time(&c.tr_stale, &tm), DS3231_STALE);
+    CHECK_EQ(c.stale_served, 1);
+    CHECK_EQ(c.cur.xfers, 0);
+    CHECK_EQ(mock.xfers, 0);
+
+    // Nothing to fall back to for a register written since its last read
+    CHECK_EQ(ds3231_set_ctl(&c.tr, RTC_CTL_BIT_INTCN), -EIO);
+    ds3231_cache_begin(&c, DS3231_OP_IOCTL_RD_STATUS, c.reads_started);
+    CHECK_EQ(ds3231_get_alarm1(&c.tr_stale, alarm), DS3231_STALE);
+    CHECK_EQ(ds3231_get_status(&c.tr_stale, &(struct ds3231_status){ 0 }), -EIO);
+    mock.fail = false;
+}
+
+/* register cache end */
+
+/* budgets start */
+
+// The cache in front of the mock, as the driver runs every operation
+struct budget_run {
+    struct ds3231_mock mock;
+    struct ds3231_transport bus;
+    struct ds3231_cache cache;
+    unsigned long xfers, bytes;
+};
+
+// Start op with nothing to share from earlier operations
+static void op_begin(struct budget_run *run, enum ds3231_op op)
+{
+    ds3231_cache_begin(&run->cache, op, run->cache.reads_started);
+    run->xfers = run->mock.xfers;
+    run->bytes = run->mock.bytes;
+}
+
+// The cache counts what went on the bus, the driver checks that against the budget
+static void op_end(struct budget_run *run)
+{
+    const struct ds3231_cache *c = &run->cache;
+    const struct ds3231_op_budget *budget = &ds3231_budgets[c->cur.op];
+
+    CHECK_EQ(c->cur.xfers, run->mock.xfers - run->xfers);
+    CHECK_EQ(c->cur.bytes, run->mock.bytes - run->bytes);
+    checks++;
+    if (c->cur.xfers > budget->max_xfers || c->cur.bytes > budget->max_bytes) {
+        failures++;
+        fprintf(stderr, "%s:%d: %s used %u transactions / %u bytes, budget is %u / %u\n",
+                __FILE__, __LINE__, budget->name, c->cur.xfers, c->cur.bytes, budget->max_xfers, budget->max_bytes);
+    }
+}
+
+static void budget_init(struct budget_run *run)
+{
+    ds3231_mock_init(&run->mock, &run->bus);
+    ds3231_cache_init(&run->cache, &run->bus);
+    set_mock_time(&run->mock, 24, 2, 10, 12, 0, 0);
+}
+
+// Worst case for the alarm writes: interrupt to enable and flag to clear every time
+static void alarm_worst_case(struct budget_run *run)
+{
+    run->mock.regs[RTC_CTL_REG_ADDR] &= ~RTC_CTL_BIT_A1IE;
+    run->mock.regs[RTC_STAT_REG_ADDR] |= RTC_STAT_BIT_A1F;
+}
+
+// Every driver operation, with the core calls its handler makes in the order it makes them
+static void test_budgets(void)
+{
+    static const enum ds3231_op rd_time[] = {
+        DS3231_OP_IOCTL_RD_TIME, DS3231_OP_SYSFS_RTC_SHOW, DS3231_OP_PROC_READ,
+    };
+    static const enum ds3231_op wr_time[] = { DS3231_OP_IOCTL_WR_TIME, DS3231_OP_SYSFS_RTC_STORE };
+    static const enum ds3231_op rd_alarm[] = {
+        DS3231_OP_IOCTL_RD_ALARM1, DS3231_OP_IOCTL_RD_ALM1_MODE,
+        DS3231_OP_SYSFS_ALARM_SHOW, DS3231_OP_SYSFS_ALARM_MODE_SHOW,
+    };
+    static const enum ds3231_op wr_after[] = { DS3231_OP_IOCTL_WR_ALARM1, DS3231_OP_SYSFS_ALARM_STORE };
+    static const enum ds3231_op wr_mode[] = { DS3231_OP_IOCTL_WR_ALM1_MODE, DS3231_OP_SYSFS_ALARM_MODE_STORE };
+    static const enum ds3231_op wr_abs[] = {
+        DS3231_OP_IOCTL_WR_ALM1_ABS, DS3231_OP_SYSFS_ALARM_AT_STORE, DS3231_OP_ALARM_REARM,
+    };
+    static const enum ds3231_op no_bus[] = { DS3231_OP_IOCTL_RD_ALM1_ABS, DS3231_OP_SYSFS_ALARM_AT_SHOW };
+    struct budget_run run;
+    struct ds3231_alarm1_irq irq;
+    struct ds3231_status st;
+    struct ds3231_time tm;
+    unsigned char alarm[4];
+    int64_t target;
+    unsigned int i;
+
+    budget_init(&run);
+
+    // Probe: defaults, time from the system, time printed. Then the load reads the status.
+    op_begin(&run, DS3231_OP_INIT);
+    CHECK_EQ(ds3231_init_chip(&run.cache.tr), 0);
+    CHECK_EQ(ds3231_set_time(&run.cache.tr, &tm_leap), 0);
+    CHECK_EQ(ds3231_get_time(&run.cache.tr_stale, &tm), 0);
+    op_end(&run);
+    op_begin(&run, DS3231_OP_INIT);
+    CHECK_EQ(ds3231_get_status(&run.cache.tr, &st), 0);
+    op_end(&run);
+
+    for (i = 0; i < sizeof(rd_time) / sizeof(rd_time[0]); i++) {
+        op_begin(&run, rd_time[i]);
+        CHECK_EQ(ds3231_get_time(&run.cache.tr_stale, &tm), 0);
+        op_end(&run);
+    }
+    for (i = 0; i < sizeof(wr_time) / sizeof(wr_time[0]); i++) {
+        op_begin(&run, wr_time[i]);
+        CHECK_EQ(ds3231_set_time(&run.cache.tr, &tm_leap), 0);
+        op_end(&run);
+    }
+    for (i = 0; i < sizeof(rd_alarm) / sizeof(rd_alarm[0]); i++) {
+        op_begin(&run, rd_alarm[i]);
+        CHECK_EQ(ds3231_get_alarm1(&run.cache.tr_stale, alarm), 0);
+        op_end(&run);
+    }
+    for (i = 0; i < sizeof(no_bus) / sizeof(no_bus[0]); i++) {
+        op_begin(&run, no_bus[i]);
+        op_end(&run);
+    }
+
+    for (i = 0; i < sizeof(wr_after) / sizeof(wr_after[0]); i++) {
+        alarm_worst_case(&run);
+        op_begin(&run, wr_after[i]);
+        CHECK_EQ(ds3231_set_alarm1_after(&run.cache.tr, 0, 0, 10, &target), 0);
+        op_end(&run);
+    }
+    for (i = 0; i < sizeof(wr_mode) / sizeof(wr_mode[0]); i++) {
+        alarm_worst_case(&run);
+        ds3231_encode_alarm1(DS3231_ALM_MATCH_DAY, 3, 1, 2, 3, alarm);
+        op_begin(&run, wr_mode[i]);
+        CHECK_EQ(ds3231_set_alarm1(&run.cache.tr, alarm), 0);
+        op_end(&run);
+    }
+    for (i = 0; i < sizeof(wr_abs) / sizeof(wr_abs[0]); i++) {
+        alarm_worst_case(&run);
+        op_begin(&run, wr_abs[i]);
+        CHECK(ds3231_arm_alarm1_abs(&run.cache.tr, ds3231_regs_to_time(run.mock.regs) + 40 * 86400) >= 0);
+        op_end(&run);
+    }
+
+    op_begin(&run, DS3231_OP_IOCTL_RD_STATUS);
+    CHECK_EQ(ds3231_get_status(&run.cache.tr_stale, &st), 0);
+    op_end(&run);
+
+    op_begin(&run, DS3231_OP_HIRES_RATE);
+    CHECK_EQ(ds3231_set_sqw(&run.cache.tr, 8192), 0);
+    op_end(&run);
+
+    // Suspend in high resolution mode puts the alarm back on the pin, resume finds the
+    // control register reset
+    op_begin(&run, DS3231_OP_PM_SUSPEND);
+    CHECK_EQ(ds3231_get_status(&run.cache.tr, &st), 0);
+    CHECK_EQ(ds3231_set_sqw(&run.cache.tr, 0), 0);
+    op_end(&run);
+    run.mock.regs[RTC_CTL_REG_ADDR] = RTC_CTL_BIT_INTCN | RTC_CTL_BIT_RS1 | RTC_CTL_BIT_RS2;
+    op_begin(&run, DS3231_OP_PM_RESUME);
+    CHECK_EQ(ds3231_get_status(&run.cache.tr, &st), 0);
+    CHECK(st.ctl != RTC_CTL_BIT_RS1);
+    CHECK_EQ(ds3231_set_ctl(&run.cache.tr, RTC_CTL_BIT_RS1), 0);
+    op_end(&run);
+
+    // Alarm work for a one-shot alarm with listeners: time, control and status in one read,
+    // then interrupt and flag off in one write. An intermediate alarm only clears the flag.
+    alarm_worst_case(&run);
+    run.mock.regs[RTC_CTL_REG_ADDR] |= RTC_CTL_BIT_A1IE;
+    op_begin(&run, DS3231_OP_ALARM_IRQ);
+    CHECK_EQ(ds3231_get_alarm1_irq(&run.cache.tr, true, &irq), 0);
+    CHECK_EQ(irq.rtc_sec, ds3231_regs_to_time(run.mock.regs));
+    CHECK_EQ(ds3231_ack_alarm1(&run.cache.tr, &irq, true), 0);
+    op_end(&run);
+    CHECK_EQ(run.mock.regs[RTC_CTL_REG_ADDR] & RTC_CTL_BIT_A1IE, 0);
+    CHECK_EQ(run.mock.regs[RTC_STAT_REG_ADDR] & RTC_STAT_BIT_A1F, 0);
+
+    alarm_worst_case(&run);
+    run.mock.regs[RTC_CTL_REG_ADDR] |= RTC_CTL_BIT_A1IE;
+    op_begin(&run, DS3231_OP_ALARM_IRQ);
+    CHECK_EQ(ds3231_get_alarm1_irq(&run.cache.tr, false, &irq), 0);
+    CHECK_EQ(irq.rtc_sec, 0);
+    CHECK_EQ(ds3231_ack_alarm1(&run.cache.tr, &irq, false), 0);
+    op_end(&run);
+    CHECK_EQ(run.mock.regs[RTC_CTL_REG_ADDR] & RTC_CTL_BIT_A1IE, RTC_CTL_BIT_A1IE);
+    CHECK_EQ(run.mock.regs[RTC_STAT_REG_ADDR] & RTC_STAT_BIT_A1F, 0);
+
+    op_begin(&run, DS3231_OP_DRIFT_SAMPLE);
+    CHECK_EQ(ds3231_get_time(&run.cache.tr, &tm), 0);
+    CHECK_EQ(ds3231_get_status(&run.cache.tr, &st), 0);
+    op_end(&run);
+    CHECK_EQ(st.temp_qc, 25 * 4);
+}
+
+/* budgets end */
+
+int main(void)
+{
+    test_mock();
+    test_bcd();
+    test_time_encoding();
+    test_time_rollover();
+    test_temp();
+    test_alarm_encoding();
+    test_alarm_plan();
+    test_init_chip();
+    test_set_get_time();
+    test_get_status();
+    test_set_alarm1();
+    test_set_alarm1_after();
+    test_arm_alarm1_abs();
+    test_set_sqw();
+    test_cache();
+    test_budgets();
+
+    printf("%u checks, %u failed\n", checks, failures);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
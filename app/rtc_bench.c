@@ -0,0 +1,502 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <time.h>
+#include <errno.h>
+#include <stdatomic.h>
+#include <sys/ioctl.h>
+
+#include "ds3231_lib.h"
+
+struct rtc_value {
+    unsigned char usr_hour, usr_min, usr_sec;
+    unsigned char usr_day, usr_date, usr_month, usr_year;
+};
+
+struct alm_value {
+    unsigned char alm_hour, alm_min, alm_sec;
+};
+
+#define RD_RTC_TIME _IOR('a', 2, struct rtc_value)
+#define RD_ALM1_TIME _IOR('a', 4, struct alm_value)
+
+struct rtc_hr_value {
+    int64_t sec;
+    uint32_t nsec;
+    uint32_t rate;
+};
+
+#define RD_RTC_TIME_HR _IOR('a', 11, struct rtc_hr_value)
+
+#define DEV_PATH    "/dev/DS3231"
+#define PROC_PATH   "/proc/rtc_time"
+#define SYSFS_PATH  "/sys/kernel/rtc_sysfs/rtc_time"
+#define STATS_PATH  "/sys/kernel/rtc_sysfs/stats"
+#define BUDGETS_PATH "/sys/kernel/rtc_sysfs/budgets"
+
+// Latency histogram: 16 linear sub-buckets per power of two of nanoseconds
+#define HIST_SUB_BITS   4
+#define HIST_SUB        (1 << HIST_SUB_BITS)
+#define HIST_BUCKETS    (64 * HIST_SUB)
+
+enum bench_iface {
+    IFACE_IOCTL_TIME,
+    IFACE_IOCTL_ALARM,
+    IFACE_PROC,
+    IFACE_SYSFS,
+    IFACE_IOCTL_TIME_HR,        // Needs the driver loaded with hires_rate
+    IFACE_MOCK_TIME,            // ds3231_core against the mock, no driver involved
+    IFACE_MOCK_ALARM,
+    IFACE_MAX
+};
+
+// "all" and the default cover the driver interfaces that always work
+#define IFACE_DEV_MAX   IFACE_IOCTL_TIME_HR
+
+static const char *iface_names[IFACE_MAX] = {
+    [IFACE_IOCTL_TIME]  = "ioctl-time",
+    [IFACE_IOCTL_ALARM] = "ioctl-alarm",
+    [IFACE_PROC]        = "proc",
+    [IFACE_SYSFS]       = "sysfs",
+    [IFACE_IOCTL_TIME_HR] = "ioctl-time-hr",
+    [IFACE_MOCK_TIME]   = "mock-time",
+    [IFACE_MOCK_ALARM]  = "mock-alarm",
+};
+
+struct bench_thread {
+    pthread_t tid;
+    enum bench_iface iface;
+    unsigned long max_ops;
+    uint64_t ops, errors;
+    uint64_t lat_min, lat_max, lat_sum;
+    uint64_t hist[HIST_BUCKETS];
+};
+
+struct bench_result {
+    enum bench_iface iface;
+    double elapsed;
+    uint64_t ops, errors;
+    uint64_t lat_min, lat_max, lat_sum;
+    uint64_t hist[HIST_BUCKETS];
+};
+
+static atomic_int stop_flag;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static unsigned int hist_index(uint64_t v)
+{
+    int msb;
+
+    if (v < HIST_SUB)
+        return v;
+    msb = 63 - __builtin_clzll(v);
+    return (msb - HIST_SUB_BITS + 1) * HIST_SUB + ((v >> (msb - HIST_SUB_BITS)) & (HIST_SUB - 1));
+}
+
+// Upper bound of the values that land in bucket idx
+static uint64_t hist_value(unsigned int idx)
+{
+    unsigned int shift;
+
+    if (idx < HIST_SUB)
+        return idx;
+    shift = idx / HIST_SUB - 1;
+    return ((uint64_t)(HIST_SUB + idx % HIST_SUB + 1) << shift) - 1;
+}
+
+static uint64_t hist_percentile(const uint64_t *hist, uint64_t total, double pct)
+{
+    uint64_t want = (uint64_t)(total * pct / 100.0);
+    uint64_t seen = 0;
+    unsigned int i;
+
+    if (want >= total)
+        want = total - 1;
+    for (i = 0; i < HIST_BUCKETS; i++) {
+        seen += hist[i];
+        if (seen > want)
+            return hist_value(i);
+    }
+    return 0;
+}
+
+// Read a whole text file the way `cat` does: open, read, close
+static int read_text_file(const char *path)
+{
+    char buf[512];
+    ssize_t n;
+    int fd;
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return -1;
+    do {
+        n = read(fd, buf, sizeof(buf));
+    } while (n > 0);
+    close(fd);
+    return n < 0 ? -1 : 0;
+}
+
+static int bench_one_op(enum bench_iface iface, int fd, const struct ds3231_transport *tr)
+{
+    struct rtc_value rtc_data;
+    struct alm_value alm_data;
+    struct rtc_hr_value hr_data;
+    struct ds3231_time tm;
+    unsigned char alarm[4];
+    unsigned int day, h, m, s;
+
+    switch (iface) {
+    case IFACE_IOCTL_TIME:
+        return ioctl(fd, RD_RTC_TIME, &rtc_data) < 0 ? -1 : 0;
+    case IFACE_IOCTL_ALARM:
+        return ioctl(fd, RD_ALM1_TIME, &alm_data) < 0 ? -1 : 0;
+    case IFACE_IOCTL_TIME_HR:
+        return ioctl(fd, RD_RTC_TIME_HR, &hr_data) < 0 ? -1 : 0;
+    case IFACE_PROC:
+        return read_text_file(PROC_PATH);
+    case IFACE_SYSFS:
+        return read_text_file(SYSFS_PATH);
+    case IFACE_MOCK_TIME:
+        return ds3231_get_time(tr, &tm) < 0 ? -1 : 0;
+    case IFACE_MOCK_ALARM:
+        // The same encode, write and read back as an alarm mode ioctl pair
+        if (ds3231_encode_alarm1(DS3231_ALM_MATCH_HMS, 1, 12, 34, 56, alarm) < 0 ||
+            ds3231_set_alarm1(tr, alarm) < 0 || ds3231_get_alarm1(tr, alarm) < 0)
+            return -1;
+        return ds3231_decode_alarm1(alarm, &day, &h, &m, &s) < 0 ? -1 : 0;
+    default:
+        return -1;
+    }
+}
+
+static void *bench_thread_fn(void *arg)
+{
+    struct bench_thread *t = arg;
+    struct ds3231_transport tr;
+    struct ds3231_mock mock;
+    int fd = -1;
+
+    t->lat_min = UINT64_MAX;
+    ds3231_mock_init(&mock, &tr);
+
+    if (t->iface == IFACE_IOCTL_TIME || t->iface == IFACE_IOCTL_ALARM ||
+        t->iface == IFACE_IOCTL_TIME_HR) {
+        fd = open(DEV_PATH, O_RDWR);
+        if (fd < 0) {
+            perror("Failed to open the device file");
+            t->errors++;
+            return NULL;
+        }
+    }
+
+    while (!atomic_load_explicit(&stop_flag, memory_order_relaxed)) {
+        uint64_t start, lat;
+
+        if (t->max_ops && t->ops + t->errors >= t->max_ops)
+            break;
+
+        start = now_ns();
+        if (bench_one_op(t->iface, fd, &tr) < 0) {
+            t->errors++;
+            continue;
+        }
+        lat = now_ns() - start;
+
+        t->ops++;
+        t->lat_sum += lat;
+        if (lat < t->lat_min)
+            t->lat_min = lat;
+        if (lat > t->lat_max)
+            t->lat_max = lat;
+        t->hist[hist_index(lat)]++;
+    }
+
+    if (fd >= 0)
+        close(fd);
+    return NULL;
+}
+
+static int run_bench(enum bench_iface iface, int nthreads, unsigned int duration,
+                     unsigned long ops_per_thread, struct bench_result *res)
+{
+    struct bench_thread *threads;
+    uint64_t start;
+    int i, j;
+
+    threads = calloc(nthreads, sizeof(*threads));
+    if (!threads)
+        return -ENOMEM;
+
+    atomic_store(&stop_flag, 0);
+    start = now_ns();
+
+    for (i = 0; i < nthreads; i++) {
+        threads[i].iface = iface;
+        threads[i].max_ops = ops_per_thread;
+        if (pthread_create(&threads[i].tid, NULL, bench_thread_fn, &threads[i])) {
+            perror("pthread_create");
+            atomic_store(&stop_flag, 1);
+            nthreads = i;
+            break;
+        }
+    }
+
+    // A fixed op count ends the run on its own, otherwise stop after the duration
+    if (!ops_per_thread) {
+        struct timespec ts = { .tv_sec = duration, .tv_nsec = 0 };
+
+        while (nanosleep(&ts, &ts) < 0 && errno == EINTR)
+            ;
+        atomic_store(&stop_flag, 1);
+    }
+
+    memset(res, 0, sizeof(*res));
+    res->iface = iface;
+    res->lat_min = UINT64_MAX;
+
+    for (i = 0; i < nthreads; i++) {
+        pthread_join(threads[i].tid, NULL);
+
+        res->ops += threads[i].ops;
+        res->errors += threads[i].errors;
+        res->lat_sum += threads[i].lat_sum;
+        if (threads[i].lat_min < res->lat_min)
+            res->lat_min = threads[i].lat_min;
+        if (threads[i].lat_max > res->lat_max)
+            res->lat_max = threads[i].lat_max;
+        for (j = 0; j < HIST_BUCKETS; j++)
+            res->hist[j] += threads[i].hist[j];
+    }
+    res->elapsed = (now_ns() - start) / 1e9;
+
+    free(threads);
+    return 0;
+}
+
+// Clear the driver's per-operation I2C statistics
+static int stats_reset(void)
+{
+    int fd, ret;
+
+    fd = open(STATS_PATH, O_WRONLY);
+    if (fd < 0)
+        return -1;
+    ret = write(fd, "reset", 5) == 5 ? 0 : -1;
+    close(fd);
+    return ret;
+}
+
+// Print operations that exceeded their I2C budget, returns the number of violations
+static long stats_check_budgets(FILE *out)
+{
+    char line[256];
+    long total = 0;
+    FILE *f;
+
+    f = fopen(BUDGETS_PATH, "r");
+    if (!f)
+        return -1;
+    // Header first, then one row per operation with the violations in the last column
+    while (fgets(line, sizeof(line), f)) {
+        char *p = strrchr(line, ' ');
+        long n = p ? strtol(p + 1, NULL, 10) : 0;
+
+        if (n > 0) {
+            fprintf(out, "budget violation: %s", line);
+            total += n;
+        }
+    }
+    fclose(f);
+    return total;
+}
+
+static void print_text(const struct bench_result *res, int nthreads)
+{
+    printf("%-12s threads=%-3d ops=%-10llu errors=%-6llu ops/sec=%-10.1f",
+           iface_names[res->iface], nthreads,
+           (unsigned long long)res->ops, (unsigned long long)res->errors,
+           res->ops / res->elapsed);
+    if (res->ops) {
+        printf(" lat_us: min=%.1f p50=%.1f p99=%.1f p999=%.1f max=%.1f mean=%.1f",
+               res->lat_min / 1e3,
+               hist_percentile(res->hist, res->ops, 50.0) / 1e3,
+               hist_percentile(res->hist, res->ops, 99.0) / 1e3,
+               hist_percentile(res->hist, res->ops, 99.9) / 1e3,
+               res->lat_max / 1e3,
+               (double)res->lat_sum / res->ops / 1e3);
+    }
+    printf("\n");
+}
+
+static void print_json(const struct bench_result *res, int nthreads, int last)
+{
+    printf("    {\"interface\": \"%s\", \"threads\": %d, \"elapsed_s\": %.3f, "
+           "\"ops\": %llu, \"errors\": %llu, \"ops_per_sec\": %.1f",
+           iface_names[res->iface], nthreads, res->elapsed,
+           (unsigned long long)res->ops, (unsigned long long)res->errors,
+           res->ops / res->elapsed);
+    if (res->ops) {
+        printf(", \"latency_ns\": {\"min\": %llu, \"p50\": %llu, \"p99\": %llu, "
+               "\"p999\": %llu, \"max\": %llu, \"mean\": %llu}",
+               (unsigned long long)res->lat_min,
+               (unsigned long long)hist_percentile(res->hist, res->ops, 50.0),
+               (unsigned long long)hist_percentile(res->hist, res->ops, 99.0),
+               (unsigned long long)hist_percentile(res->hist, res->ops, 99.9),
+               (unsigned long long)res->lat_max,
+               (unsigned long long)(res->lat_sum / res->ops));
+    }
+    printf("}%s\n", last ? "" : ",");
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s [-i iface] [-t threads] [-d seconds | -n ops] [-j] [-b]\n"
+            "  -i iface    ioctl-time, ioctl-alarm, proc, sysfs or all (default all, repeatable),\n"
+            "              ioctl-time-hr with the driver in high resolution mode,\n"
+            "              or mock-time, mock-alarm or mock for the register core without a driver\n"
+            "  -t threads  number of concurrent threads (default 4)\n"
+            "  -d seconds  run each interface for this long (default 5)\n"
+            "  -n ops      run this many operations per thread instead of a fixed duration\n"
+            "  -j          print results as JSON\n"
+            "  -b          fail if any driver operation exceeded its I2C transaction budget\n",
+            prog);
+}
+
+int main(int argc, char *argv[])
+{
+    int selected[IFACE_MAX] = { 0 };
+    struct bench_result *res;
+    unsigned long ops_per_thread = 0;
+    unsigned int duration = 5;
+    int nthreads = 4;
+    int json = 0;
+    int check_budgets = 0;
+    long violations = 0;
+    int any = 0;
+    int opt, i, n, count;
+    int failed = 0;
+
+    while ((opt = getopt(argc, argv, "i:t:d:n:jbh")) != -1) {
+        switch (opt) {
+        case 'i':
+            if (!strcmp(optarg, "all")) {
+                for (i = 0; i < IFACE_DEV_MAX; i++)
+                    selected[i] = 1;
+                any = 1;
+                break;
+            }
+            if (!strcmp(optarg, "mock")) {
+                for (i = IFACE_MOCK_TIME; i < IFACE_MAX; i++)
+                    selected[i] = 1;
+                any = 1;
+                break;
+            }
+            for (i = 0; i < IFACE_MAX; i++) {
+                if (!strcmp(optarg, iface_names[i]))
+                    break;
+            }
+            if (i == IFACE_MAX) {
+                fprintf(stderr, "Unknown interface: %s\n", optarg);
+                usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            selected[i] = 1;
+            any = 1;
+            break;
+        case 't':
+            nthreads = atoi(optarg);
+            break;
+        case 'd':
+            duration = strtoul(optarg, NULL, 0);
+            break;
+        case 'n':
+            ops_per_thread = strtoul(optarg, NULL, 0);
+            break;
+        case 'j':
+            json = 1;
+            break;
+        case 'b':
+            check_budgets = 1;
+            break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+
+    if (nthreads <= 0 || (!duration && !ops_per_thread)) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (!any) {
+        for (i = 0; i < IFACE_DEV_MAX; i++)
+            selected[i] = 1;
+    }
+
+    res = calloc(IFACE_MAX, sizeof(*res));
+    if (!res) {
+        perror("calloc");
+        return EXIT_FAILURE;
+    }
+
+    if (check_budgets && stats_reset() < 0) {
+        perror("Failed to reset " STATS_PATH);
+        free(res);
+        return EXIT_FAILURE;
+    }
+
+    count = 0;
+    for (i = 0; i < IFACE_MAX; i++) {
+        if (!selected[i])
+            continue;
+        if (run_bench(i, nthreads, duration, ops_per_thread, &res[count]) < 0) {
+            fprintf(stderr, "Benchmark of %s failed\n", iface_names[i]);
+            free(res);
+            return EXIT_FAILURE;
+        }
+        if (res[count].errors)
+            failed = 1;
+        count++;
+    }
+
+    if (check_budgets) {
+        violations = stats_check_budgets(stderr);
+        if (violations < 0) {
+            perror("Failed to read " STATS_PATH);
+            free(res);
+            return EXIT_FAILURE;
+        }
+        if (violations)
+            failed = 1;
+    }
+
+    if (json) {
+        printf("{\n  \"results\": [\n");
+        for (n = 0; n < count; n++)
+            print_json(&res[n], nthreads, n == count - 1);
+        printf("  ]");
+        if (check_budgets)
+            printf(",\n  \"budget_violations\": %ld", violations);
+        printf("\n}\n");
+    } else {
+        for (n = 0; n < count; n++)
+            print_text(&res[n], nthreads);
+    }
+
+    free(res);
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,145 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <errno.h>
+#include <sys/mman.h>
+
+#define DEV_PATH "/dev/DS3231"
+
+#define DS3231_DRIFT_MAGIC      (0x44524654)   // "DRFT"
+#define DS3231_DRIFT_VERSION    (2)
+
+#define DS3231_DRIFT_FLAG_OSF   (0x0001)
+
+struct ds3231_drift_sample {
+    int64_t rtc_sec;
+    int64_t realtime_ns;
+    int64_t monotonic_ns;
+    int16_t temp_qc;
+    uint16_t flags;
+    uint32_t seq;
+};
+
+struct ds3231_drift_ring {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t nr_entries;
+    uint32_t entry_size;
+    uint32_t data_offset;
+    uint32_t interval_ms;
+    uint64_t head;
+    uint64_t tail_offset;
+    uint64_t dropped;
+};
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s [-f] [-p ms]\n"
+            "  -f      follow: keep consuming new samples until interrupted\n"
+            "  -p ms   polling period in follow mode (default: 8 sampling intervals)\n"
+            "Set the sampling interval with /sys/module/rtc/parameters/drift_interval_ms\n",
+            prog);
+}
+
+int main(int argc, char *argv[])
+{
+    struct ds3231_drift_ring *ring;
+    const struct ds3231_drift_sample *samples;
+    uint64_t *tail_page;
+    unsigned int poll_ms = 0;
+    uint64_t head, tail, dropped = 0;
+    size_t size;
+    int follow = 0;
+    int fd, opt;
+
+    while ((opt = getopt(argc, argv, "fp:h")) != -1) {
+        switch (opt) {
+        case 'f':
+            follow = 1;
+            break;
+        case 'p':
+            poll_ms = strtoul(optarg, NULL, 0);
+            break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+
+    fd = open(DEV_PATH, O_RDWR);
+    if (fd < 0) {
+        perror("Failed to open the device file");
+        return errno;
+    }
+
+    // Map the header first to learn the ring size
+    ring = mmap(NULL, getpagesize(), PROT_READ, MAP_SHARED, fd, 0);
+    if (ring == MAP_FAILED) {
+        perror("Failed to map the drift ring buffer");
+        close(fd);
+        return EXIT_FAILURE;
+    }
+    if (ring->magic != DS3231_DRIFT_MAGIC || ring->version != DS3231_DRIFT_VERSION ||
+        ring->entry_size != sizeof(struct ds3231_drift_sample)) {
+        fprintf(stderr, "Unsupported drift ring buffer layout\n");
+        munmap(ring, getpagesize());
+        close(fd);
+        return EXIT_FAILURE;
+    }
+    size = ring->data_offset + (size_t)ring->nr_entries * ring->entry_size;
+    munmap(ring, getpagesize());
+
+    // The ring is read-only, the reader only writes its tail, which has a page of its own
+    ring = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (ring == MAP_FAILED) {
+        perror("Failed to map the drift ring buffer");
+        close(fd);
+        return EXIT_FAILURE;
+    }
+    tail_page = mmap(NULL, getpagesize(), PROT_READ | PROT_WRITE, MAP_SHARED, fd, ring->tail_offset);
+    if (tail_page == MAP_FAILED) {
+        perror("Failed to map the drift ring tail");
+        munmap(ring, size);
+        close(fd);
+        return EXIT_FAILURE;
+    }
+    samples = (const struct ds3231_drift_sample *)((const char *)ring + ring->data_offset);
+
+    printf("seq,rtc_sec,realtime_ns,monotonic_ns,drift_ms,temp_c,osf\n");
+
+    do {
+        head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+        tail = *tail_page;
+
+        for (; tail != head; tail++) {
+            const struct ds3231_drift_sample *s = &samples[tail & (ring->nr_entries - 1)];
+
+            printf("%u,%lld,%lld,%lld,%.3f,%.2f,%d\n", s->seq,
+                   (long long)s->rtc_sec, (long long)s->realtime_ns, (long long)s->monotonic_ns,
+                   (s->rtc_sec * 1e9 - s->realtime_ns) / 1e6, s->temp_qc / 4.0,
+                   !!(s->flags & DS3231_DRIFT_FLAG_OSF));
+        }
+        // Hand the consumed slots back to the driver
+        __atomic_store_n(tail_page, tail, __ATOMIC_RELEASE);
+
+        if (ring->dropped != dropped) {
+            fprintf(stderr, "%llu samples dropped, ring buffer was full\n",
+                    (unsigned long long)(ring->dropped - dropped));
+            dropped = ring->dropped;
+        }
+        fflush(stdout);
+
+        if (follow)
+            usleep(1000u * (poll_ms ? poll_ms : 8 * (ring->interval_ms ? ring->interval_ms : 1000)));
+    } while (follow);
+
+    munmap(tail_page, getpagesize());
+    munmap(ring, size);
+    close(fd);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,180 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
+#include <linux/genetlink.h>
+
+// Generic netlink family and attributes of the DS3231 driver
+#define DS3231_GENL_NAME        "DS3231"
+#define DS3231_GENL_MCGRP_NAME  "events"
+
+enum ds3231_genl_attr {
+    DS3231_ATTR_UNSPEC,
+    DS3231_ATTR_TYPE,
+    DS3231_ATTR_SEQ,
+    DS3231_ATTR_REALTIME_NS,
+    DS3231_ATTR_MONOTONIC_NS,
+    DS3231_ATTR_RTC_SEC,
+    DS3231_ATTR_STATUS,
+    DS3231_ATTR_PAD,
+    __DS3231_ATTR_MAX,
+};
+
+static const char *event_names[] = { "unknown", "alarm1", "osf", "time_set" };
+
+#define BUF_SIZE 8192
+
+#define GENLMSG_DATA(nlh)   ((char *)NLMSG_DATA(nlh) + GENL_HDRLEN)
+#define NLA_DATA(nla)       ((char *)(nla) + NLA_HDRLEN)
+
+// Split an attribute stream into tb[type], unknown types are ignored
+static void parse_attrs(struct nlattr **tb, int max, char *data, int len)
+{
+    struct nlattr *nla;
+
+    memset(tb, 0, sizeof(*tb) * (max + 1));
+    for (nla = (struct nlattr *)data; len >= NLA_HDRLEN && nla->nla_len >= NLA_HDRLEN && nla->nla_len <= len;
+         len -= NLA_ALIGN(nla->nla_len), nla = (struct nlattr *)((char *)nla + NLA_ALIGN(nla->nla_len))) {
+        int type = nla->nla_type & NLA_TYPE_MASK;
+
+        if (type <= max)
+            tb[type] = nla;
+    }
+}
+
+// Look up the family id and the multicast group id through the generic netlink controller
+static int resolve_family(int fd, uint32_t *grp_id)
+{
+    struct {
+        struct nlmsghdr nlh;
+        struct genlmsghdr genl;
+        char attrs[64];
+    } req;
+    struct nlattr *nla, *tb[CTRL_ATTR_MAX + 1], *grp[CTRL_ATTR_MCAST_GRP_MAX + 1];
+    struct nlmsghdr *nlh;
+    char buf[BUF_SIZE];
+    int len, rem;
+
+    memset(&req, 0, sizeof(req));
+    req.nlh.nlmsg_type = GENL_ID_CTRL;
+    req.nlh.nlmsg_flags = NLM_F_REQUEST;
+    req.genl.cmd = CTRL_CMD_GETFAMILY;
+    req.genl.version = 1;
+    nla = (struct nlattr *)req.attrs;
+    nla->nla_type = CTRL_ATTR_FAMILY_NAME;
+    nla->nla_len = NLA_HDRLEN + sizeof(DS3231_GENL_NAME);
+    memcpy(NLA_DATA(nla), DS3231_GENL_NAME, sizeof(DS3231_GENL_NAME));
+    req.nlh.nlmsg_len = NLMSG_LENGTH(GENL_HDRLEN) + NLA_ALIGN(nla->nla_len);
+
+    if (send(fd, &req, req.nlh.nlmsg_len, 0) < 0)
+        return -errno;
+    len = recv(fd, buf, sizeof(buf), 0);
+    if (len < 0)
+        return -errno;
+
+    nlh = (struct nlmsghdr *)buf;
+    if (!NLMSG_OK(nlh, len))
+        return -EIO;
+    if (nlh->nlmsg_type == NLMSG_ERROR)
+        return ((struct nlmsgerr *)NLMSG_DATA(nlh))->error;
+
+    parse_attrs(tb, CTRL_ATTR_MAX, GENLMSG_DATA(nlh), nlh->nlmsg_len - NLMSG_LENGTH(GENL_HDRLEN));
+    if (!tb[CTRL_ATTR_MCAST_GROUPS])
+        return -ENOENT;
+
+    // Nested list of groups, each one a nested name/id pair
+    nla = (struct nlattr *)NLA_DATA(tb[CTRL_ATTR_MCAST_GROUPS]);
+    rem = tb[CTRL_ATTR_MCAST_GROUPS]->nla_len - NLA_HDRLEN;
+    for (; rem >= NLA_HDRLEN && nla->nla_len >= NLA_HDRLEN && nla->nla_len <= rem;
+         rem -= NLA_ALIGN(nla->nla_len), nla = (struct nlattr *)((char *)nla + NLA_ALIGN(nla->nla_len))) {
+        parse_attrs(grp, CTRL_ATTR_MCAST_GRP_MAX, NLA_DATA(nla), nla->nla_len - NLA_HDRLEN);
+        if (grp[CTRL_ATTR_MCAST_GRP_NAME] && grp[CTRL_ATTR_MCAST_GRP_ID] &&
+            !strcmp(NLA_DATA(grp[CTRL_ATTR_MCAST_GRP_NAME]), DS3231_GENL_MCGRP_NAME)) {
+            *grp_id = *(uint32_t *)NLA_DATA(grp[CTRL_ATTR_MCAST_GRP_ID]);
+            return 0;
+        }
+    }
+    return -ENOENT;
+}
+
+static int64_t attr_s64(struct nlattr *nla)
+{
+    int64_t v = 0;
+
+    if (nla)
+        memcpy(&v, NLA_DATA(nla), sizeof(v));
+    return v;
+}
+
+static uint32_t attr_u32(struct nlattr *nla)
+{
+    return nla ? *(uint32_t *)NLA_DATA(nla) : 0;
+}
+
+int main(int argc, char *argv[])
+{
+    struct sockaddr_nl addr = { .nl_family = AF_NETLINK };
+    struct nlattr *tb[__DS3231_ATTR_MAX];
+    char buf[BUF_SIZE];
+    uint32_t grp_id;
+    int fd, ret, len;
+
+    if (argc > 1) {
+        fprintf(stderr, "Usage: %s\nPrints DS3231 driver events until interrupted\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    fd = socket(AF_NETLINK, SOCK_RAW, NETLINK_GENERIC);
+    if (fd < 0 || bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        perror("Failed to open a generic netlink socket");
+        return EXIT_FAILURE;
+    }
+
+    ret = resolve_family(fd, &grp_id);
+    if (ret < 0) {
+        fprintf(stderr, "Cannot find the %s netlink family: %s\n", DS3231_GENL_NAME, strerror(-ret));
+        close(fd);
+        return EXIT_FAILURE;
+    }
+    if (setsockopt(fd, SOL_NETLINK, NETLINK_ADD_MEMBERSHIP, &grp_id, sizeof(grp_id)) < 0) {
+        perror("Failed to join the events group");
+        close(fd);
+        return EXIT_FAILURE;
+    }
+
+    while ((len = recv(fd, buf, sizeof(buf), 0)) > 0) {
+        struct nlmsghdr *nlh;
+
+        for (nlh = (struct nlmsghdr *)buf; NLMSG_OK(nlh, len); nlh = NLMSG_NEXT(nlh, len)) {
+            struct timespec now;
+            uint32_t type;
+            int64_t mono;
+
+            if (nlh->nlmsg_type < NLMSG_MIN_TYPE)
+                continue;
+            clock_gettime(CLOCK_MONOTONIC, &now);
+
+            parse_attrs(tb, __DS3231_ATTR_MAX - 1, GENLMSG_DATA(nlh), nlh->nlmsg_len - NLMSG_LENGTH(GENL_HDRLEN));
+            type = attr_u32(tb[DS3231_ATTR_TYPE]);
+            mono = attr_s64(tb[DS3231_ATTR_MONOTONIC_NS]);
+
+            printf("seq=%u event=%s rtc_sec=%lld realtime_ns=%lld monotonic_ns=%lld status=0x%02x delivery_us=%lld\n",
+                   attr_u32(tb[DS3231_ATTR_SEQ]),
+                   type < sizeof(event_names) / sizeof(event_names[0]) ? event_names[type] : "unknown",
+                   (long long)attr_s64(tb[DS3231_ATTR_RTC_SEC]),
+                   (long long)attr_s64(tb[DS3231_ATTR_REALTIME_NS]), (long long)mono,
+                   tb[DS3231_ATTR_STATUS] ? *(uint8_t *)NLA_DATA(tb[DS3231_ATTR_STATUS]) : 0,
+                   (long long)((now.tv_sec * 1000000000LL + now.tv_nsec - mono) / 1000));
+            fflush(stdout);
+        }
+    }
+
+    perror("recv");
+    close(fd);
+    return EXIT_FAILURE;
+}
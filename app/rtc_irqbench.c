@@ -0,0 +1,415 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <poll.h>
+#include <time.h>
+#include <errno.h>
+
+// Event record returned by read() on /dev/DS3231
+struct ds3231_event_rec {
+    uint32_t type;
+    uint32_t seq;
+    int64_t rtc_sec;
+    int64_t realtime_ns;
+    int64_t monotonic_ns;
+    uint8_t status;
+    uint8_t pad[7];
+};
+
+#define DS3231_EVENT_ALARM1 1
+
+#define DEV_PATH        "/dev/DS3231"
+#define LATENCY_PATH    "/sys/kernel/rtc_sysfs/irq_latency"
+#define INJECT_PATH     "/sys/kernel/ds3231_sim/inject_a1f"
+
+// Must match DS3231_LAT_BUCKETS in the driver
+#define LAT_BUCKETS     40
+
+enum user_stage {
+    STAGE_INJECT_EVENT,     // Edge injected to alarm event queued by the driver
+    STAGE_EVENT_USER,       // Alarm event queued to read() returning it
+    STAGE_INJECT_USER,      // End to end
+    STAGE_MAX
+};
+
+static const char *stage_names[STAGE_MAX] = {
+    [STAGE_INJECT_EVENT] = "inject_event",
+    [STAGE_EVENT_USER]   = "event_user",
+    [STAGE_INJECT_USER]  = "inject_user",
+};
+
+// Driver side of the alarm path, from /sys/kernel/rtc_sysfs/irq_latency
+struct drv_stage {
+    unsigned long count;
+    unsigned long long min_ns, avg_ns, max_ns;
+    unsigned long hist[LAT_BUCKETS];
+};
+
+struct drv_latency {
+    unsigned long irqs, coalesced, works, alarms;
+    struct drv_stage irq_work, work_event;
+};
+
+struct bench {
+    int dev_fd, inject_fd, pull_fd;
+    unsigned long injected, events, unmatched, seq_gaps;
+    uint32_t last_seq;
+    unsigned long next_match;           // Oldest injection not consumed by an event
+    int64_t *inject_ns;
+    int64_t *lat[STAGE_MAX];
+    unsigned long nlat;
+};
+
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static int write_str(int fd, const char *s)
+{
+    ssize_t len = strlen(s);
+
+    return pwrite(fd, s, len, 0) == len ? 0 : -1;
+}
+
+static int write_file(const char *path, const char *s)
+{
+    int fd = open(path, O_WRONLY);
+    int ret;
+
+    if (fd < 0)
+        return -1;
+    ret = write_str(fd, s);
+    close(fd);
+    return ret;
+}
+
+// A1F in the model first, then the falling edge, so the driver finds the flag it is told about
+static int inject_one(struct bench *b)
+{
+    if (write_str(b->inject_fd, "1") < 0)
+        return -1;
+    b->inject_ns[b->injected] = now_ns();
+    if (write_str(b->pull_fd, "pull-down") < 0 || write_str(b->pull_fd, "pull-up") < 0)
+        return -1;
+    b->injected++;
+    return 0;
+}
+
+// An event covers every edge injected before the driver queued it. Its latency is taken from the
+// oldest of them, the others were merged into it.
+static void match_event(struct bench *b, const struct ds3231_event_rec *ev, int64_t recv_ns)
+{
+    int64_t first;
+
+    if (b->events && ev->seq != b->last_seq + 1)
+        b->seq_gaps += ev->seq - b->last_seq - 1;
+    b->last_seq = ev->seq;
+    b->events++;
+
+    if (b->next_match == b->injected || b->inject_ns[b->next_match] > ev->monotonic_ns) {
+        b->unmatched++;
+        return;
+    }
+    first = b->inject_ns[b->next_match];
+    while (b->next_match < b->injected && b->inject_ns[b->next_match] <= ev->monotonic_ns)
+        b->next_match++;
+
+    b->lat[STAGE_INJECT_EVENT][b->nlat] = ev->monotonic_ns - first;
+    b->lat[STAGE_EVENT_USER][b->nlat] = recv_ns - ev->monotonic_ns;
+    b->lat[STAGE_INJECT_USER][b->nlat] = recv_ns - first;
+    b->nlat++;
+}
+
+// Read alarm events until deadline, returns the number read or -1
+static int drain_events(struct bench *b, int64_t deadline)
+{
+    struct ds3231_event_rec ev[16];
+    struct pollfd pfd = { .fd = b->dev_fd, .events = POLLIN };
+    int64_t recv_ns, left;
+    ssize_t len;
+    int n = 0, i, ret;
+
+    while ((left = deadline - now_ns()) > 0) {
+        ret = poll(&pfd, 1, (int)((left + 999999) / 1000000));
+        if (ret < 0 && errno != EINTR)
+            return -1;
+        if (ret <= 0)
+            continue;
+
+        len = read(b->dev_fd, ev, sizeof(ev));
+        recv_ns = now_ns();
+        if (len < 0) {
+            if (errno == EAGAIN || errno == EINTR)
+                continue;
+            return -1;
+        }
+        for (i = 0; i < len / (ssize_t)sizeof(ev[0]); i++) {
+            if (ev[i].type != DS3231_EVENT_ALARM1)
+                continue;
+            match_event(b, &ev[i], recv_ns);
+            n++;
+        }
+    }
+    return n;
+}
+
+static int parse_drv_stage(const char *line, const char *name, struct drv_stage *st)
+{
+    char fmt[96];
+    const char *p;
+    int i, n;
+
+    snprintf(fmt, sizeof(fmt), "%s: count=%%lu min_ns=%%llu avg_ns=%%llu max_ns=%%llu hist=%%n", name);
+    n = 0;
+    if (sscanf(line, fmt, &st->count, &st->min_ns, &st->avg_ns, &st->max_ns, &n) != 4 || !n)
+        return -1;
+    p = line + n;
+    for (i = 0; i < LAT_BUCKETS; i++) {
+        st->hist[i] = strtoul(p, (char **)&p, 10);
+        if (*p == ',')
+            p++;
+    }
+    return 0;
+}
+
+static int read_drv_latency(struct drv_latency *d)
+{
+    char line[1024];
+    FILE *f = fopen(LATENCY_PATH, "r");
+    int found = 0;
+
+    if (!f)
+        return -1;
+    memset(d, 0, sizeof(*d));
+    while (fgets(line, sizeof(line), f)) {
+        if (sscanf(line, "irqs=%lu coalesced=%lu works=%lu alarms=%lu",
+                   &d->irqs, &d->coalesced, &d->works, &d->alarms) == 4)
+            found++;
+        else if (!parse_drv_stage(line, "irq_work", &d->irq_work))
+            found++;
+        else if (!parse_drv_stage(line, "work_event", &d->work_event))
+            found++;
+    }
+    fclose(f);
+    return found == 3 ? 0 : -1;
+}
+
+static int cmp_s64(const void *a, const void *b)
+{
+    int64_t x = *(const int64_t *)a, y = *(const int64_t *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+static int64_t percentile(const int64_t *v, unsigned long n, double pct)
+{
+    unsigned long idx = (unsigned long)(pct / 100.0 * (n - 1) + 0.5);
+
+    return v[idx < n ? idx : n - 1];
+}
+
+// Upper bound of the log2 bucket holding the pct percentile
+static unsigned long long hist_percentile(const struct drv_stage *st, double pct)
+{
+    unsigned long long seen = 0, want = (unsigned long long)(pct / 100.0 * st->count + 0.5);
+    int i;
+
+    for (i = 0; i < LAT_BUCKETS; i++) {
+        seen += st->hist[i];
+        if (seen >= want && seen)
+            return 1ULL << (i + 1);
+    }
+    return 1ULL << LAT_BUCKETS;
+}
+
+static void print_user_stage(enum user_stage s, int64_t *v, unsigned long n, int json, int last)
+{
+    int64_t sum = 0;
+    unsigned long i;
+
+    qsort(v, n, sizeof(*v), cmp_s64);
+    for (i = 0; i < n; i++)
+        sum += v[i];
+
+    if (json) {
+        printf("    \"%s\": {\"count\": %lu", stage_names[s], n);
+        if (n)
+            printf(", \"min_ns\": %lld, \"p50_ns\": %lld, \"p99_ns\": %lld, \"p999_ns\": %lld, \"max_ns\": %lld, \"mean_ns\": %lld",
+                   (long long)v[0], (long long)percentile(v, n, 50), (long long)percentile(v, n, 99),
+                   (long long)percentile(v, n, 99.9), (long long)v[n - 1], (long long)(sum / n));
+        printf("}%s\n", last ? "" : ",");
+        return;
+    }
+
+    printf("%-13s count=%-8lu", stage_names[s], n);
+    if (n)
+        printf(" lat_us: min=%.1f p50=%.1f p99=%.1f p999=%.1f max=%.1f mean=%.1f",
+               v[0] / 1e3, percentile(v, n, 50) / 1e3, percentile(v, n, 99) / 1e3,
+               percentile(v, n, 99.9) / 1e3, v[n - 1] / 1e3, (double)sum / n / 1e3);
+    printf("\n");
+}
+
+static void print_drv_stage(const char *name, const struct drv_stage *st, int json, int last)
+{
+    if (json) {
+        printf("    \"%s\": {\"count\": %lu, \"min_ns\": %llu, \"p50_ns_le\": %llu, \"p99_ns_le\": %llu, \"max_ns\": %llu, \"mean_ns\": %llu}%s\n",
+               name, st->count, st->min_ns, hist_percentile(st, 50), hist_percentile(st, 99),
+               st->max_ns, st->avg_ns, last ? "" : ",");
+        return;
+    }
+    printf("%-13s count=%-8lu lat_us: min=%.1f p50<=%.1f p99<=%.1f max=%.1f mean=%.1f\n",
+           name, st->count, st->min_ns / 1e3, hist_percentile(st, 50) / 1e3,
+           hist_percentile(st, 99) / 1e3, st->max_ns / 1e3, st->avg_ns / 1e3);
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s -g <pull> [-n edges] [-r rate] [-b burst] [-w ms] [-j]\n"
+            "  -g pull   gpio-sim pull attribute of the line the driver was loaded with as alarm_gpio,\n"
+            "            e.g. /sys/devices/platform/gpio-sim.0/gpiochip1/sim_gpio0/pull\n"
+            "  -n edges  falling edges to inject (default 1000)\n"
+            "  -r rate   edges per second, 0 for as fast as possible (default 100)\n"
+            "  -b burst  edges injected back to back each round (default 1)\n"
+            "  -w ms     time to wait for the last events (default 1000)\n"
+            "  -j        print results as JSON\n",
+            prog);
+}
+
+int main(int argc, char *argv[])
+{
+    struct bench b = { .dev_fd = -1, .inject_fd = -1, .pull_fd = -1 };
+    struct drv_latency drv;
+    const char *pull_path = NULL;
+    unsigned long edges = 1000, burst = 1, rate = 100, wait_ms = 1000, i;
+    int64_t round_ns, next;
+    int json = 0, opt, s, failed = 0;
+
+    while ((opt = getopt(argc, argv, "g:n:r:b:w:jh")) != -1) {
+        switch (opt) {
+        case 'g':
+            pull_path = optarg;
+            break;
+        case 'n':
+            edges = strtoul(optarg, NULL, 0);
+            break;
+        case 'r':
+            rate = strtoul(optarg, NULL, 0);
+            break;
+        case 'b':
+            burst = strtoul(optarg, NULL, 0);
+            break;
+        case 'w':
+            wait_ms = strtoul(optarg, NULL, 0);
+            break;
+        case 'j':
+            json = 1;
+            break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+    if (!pull_path || !edges || !burst) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    b.inject_ns = calloc(edges, sizeof(*b.inject_ns));
+    for (s = 0; s < STAGE_MAX; s++)
+        b.lat[s] = calloc(edges, sizeof(int64_t));
+    if (!b.inject_ns || !b.lat[STAGE_INJECT_EVENT] || !b.lat[STAGE_EVENT_USER] || !b.lat[STAGE_INJECT_USER]) {
+        perror("calloc");
+        return EXIT_FAILURE;
+    }
+
+    // Events are only seen from open() on, so open before the first edge
+    b.dev_fd = open(DEV_PATH, O_RDONLY | O_NONBLOCK);
+    if (b.dev_fd < 0) {
+        perror("Failed to open " DEV_PATH);
+        return EXIT_FAILURE;
+    }
+    b.inject_fd = open(INJECT_PATH, O_WRONLY);
+    if (b.inject_fd < 0) {
+        perror("Failed to open " INJECT_PATH ", is ds3231_sim.ko loaded");
+        return EXIT_FAILURE;
+    }
+    b.pull_fd = open(pull_path, O_WRONLY);
+    if (b.pull_fd < 0 || write_str(b.pull_fd, "pull-up") < 0) {
+        perror("Failed to set the gpio-sim line");
+        return EXIT_FAILURE;
+    }
+    if (write_file(LATENCY_PATH, "reset") < 0) {
+        perror("Failed to reset " LATENCY_PATH);
+        return EXIT_FAILURE;
+    }
+
+    round_ns = rate ? (int64_t)(1000000000.0 * burst / rate) : 0;
+    next = now_ns();
+    while (b.injected < edges) {
+        for (i = 0; i < burst && b.injected < edges; i++) {
+            if (inject_one(&b) < 0) {
+                perror("Failed to inject an edge");
+                return EXIT_FAILURE;
+            }
+        }
+        next += round_ns;
+        if (drain_events(&b, next) < 0) {
+            perror("Failed to read events");
+            return EXIT_FAILURE;
+        }
+    }
+    // Wait for the tail until no event came for wait_ms
+    while (drain_events(&b, now_ns() + (int64_t)wait_ms * 1000000) > 0)
+        ;
+
+    if (read_drv_latency(&drv) < 0) {
+        perror("Failed to read " LATENCY_PATH);
+        return EXIT_FAILURE;
+    }
+
+    // Every edge should end up in an event, merged or not, unless an interrupt was lost
+    if (b.next_match < b.injected || drv.irqs < b.injected)
+        failed = 1;
+
+    if (json) {
+        printf("{\n  \"edges\": %lu, \"rate\": %lu, \"burst\": %lu,\n", b.injected, rate, burst);
+        printf("  \"counts\": {\"irqs\": %lu, \"lost_edges\": %ld, \"coalesced_irqs\": %lu, \"works\": %lu, "
+               "\"alarms\": %lu, \"events\": %lu, \"merged_edges\": %ld, \"unmatched_events\": %lu, "
+               "\"dropped_events\": %lu, \"unhandled_edges\": %lu},\n",
+               drv.irqs, (long)(b.injected - drv.irqs), drv.coalesced, drv.works, drv.alarms, b.events,
+               (long)(b.nlat ? b.next_match - b.nlat : 0), b.unmatched, b.seq_gaps,
+               b.injected - b.next_match);
+        printf("  \"stages\": {\n");
+        print_drv_stage("irq_work", &drv.irq_work, 1, 0);
+        print_drv_stage("work_event", &drv.work_event, 1, 0);
+        for (s = 0; s < STAGE_MAX; s++)
+            print_user_stage(s, b.lat[s], b.nlat, 1, s == STAGE_MAX - 1);
+        printf("  }\n}\n");
+    } else {
+        printf("edges=%lu rate=%lu burst=%lu\n", b.injected, rate, burst);
+        printf("irq:   irqs=%lu lost_edges=%ld coalesced=%lu\n",
+               drv.irqs, (long)(b.injected - drv.irqs), drv.coalesced);
+        printf("work:  works=%lu alarms=%lu\n", drv.works, drv.alarms);
+        printf("user:  events=%lu merged_edges=%ld unmatched=%lu dropped=%lu unhandled_edges=%lu\n",
+               b.events, (long)(b.nlat ? b.next_match - b.nlat : 0), b.unmatched, b.seq_gaps,
+               b.injected - b.next_match);
+        print_drv_stage("irq_work", &drv.irq_work, 0, 0);
+        print_drv_stage("work_event", &drv.work_event, 0, 0);
+        for (s = 0; s < STAGE_MAX; s++)
+            print_user_stage(s, b.lat[s], b.nlat, 0, 0);
+    }
+
+    close(b.pull_fd);
+    close(b.inject_fd);
+    close(b.dev_fd);
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,734 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <signal.h>
+#include <time.h>
+#include <errno.h>
+#include <stdatomic.h>
+#include <sys/ioctl.h>
+
+struct rtc_value {
+    unsigned char usr_hour, usr_min, usr_sec;
+    unsigned char usr_day, usr_date, usr_month, usr_year;
+};
+
+struct alm_value {
+    unsigned char alm_hour, alm_min, alm_sec;
+};
+
+#define WR_RTC_TIME _IOW('a', 1, struct rtc_value)
+#define RD_RTC_TIME _IOR('a', 2, struct rtc_value)
+#define WR_ALM1_TIME _IOW('a', 3, struct alm_value)
+#define RD_ALM1_TIME _IOR('a', 4, struct alm_value)
+
+// Returned by the read ioctls when the driver served cached values after a bus failure
+#define DS3231_STALE 1
+
+#define DEV_PATH        "/dev/DS3231"
+#define PROC_PATH       "/proc/rtc_time"
+#define SYSFS_RTC_PATH  "/sys/kernel/rtc_sysfs/rtc_time"
+#define SYSFS_ALM_PATH  "/sys/kernel/rtc_sysfs/alarm_time"
+
+// Violations printed in full, the rest are only counted
+#define MAX_REPORTED    20
+
+enum stress_kind {
+    KIND_IOCTL,
+    KIND_SYSFS,
+    KIND_PROC,
+    KIND_WRITER,
+    KIND_ALARM,
+    KIND_MAX
+};
+
+static const char *kind_names[KIND_MAX] = {
+    [KIND_IOCTL]  = "ioctl-reader",
+    [KIND_SYSFS]  = "sysfs-reader",
+    [KIND_PROC]   = "proc-reader",
+    [KIND_WRITER] = "writer",
+    [KIND_ALARM]  = "alarm",
+};
+
+enum stress_violation {
+    VIOL_BCD,           // A register is not valid BCD
+    VIOL_RANGE,         // Valid BCD but out of range for the field
+    VIOL_WEEKDAY,       // Day of week does not match the date
+    VIOL_BACKWARDS,     // Time went backwards with no set in between
+    VIOL_JUMP,          // Time advanced more than the elapsed time, e.g. a torn rollover
+    VIOL_ALARM,         // Alarm read back does not match the alarm just set
+    VIOL_PARSE,         // sysfs or procfs output could not be parsed
+    VIOL_MAX
+};
+
+static const char *viol_names[VIOL_MAX] = {
+    [VIOL_BCD]       = "bcd",
+    [VIOL_RANGE]     = "range",
+    [VIOL_WEEKDAY]   = "weekday",
+    [VIOL_BACKWARDS] = "backwards",
+    [VIOL_JUMP]      = "jump",
+    [VIOL_ALARM]     = "alarm",
+    [VIOL_PARSE]     = "parse",
+};
+
+struct stress_counters {
+    atomic_ullong ops, errors, stale;
+};
+
+// One RTC reading decoded to binary
+struct rtc_reading {
+    int hour, min, sec;
+    int day, date, month, year;
+    int stale;
+};
+
+// Last reading of a thread, used to check progression between reads
+struct rtc_track {
+    int valid;
+    unsigned long gen;
+    time_t t;
+    uint64_t start_ns;
+};
+
+struct stress_thread {
+    pthread_t tid;
+    enum stress_kind kind;
+    unsigned int id;
+};
+
+static struct stress_counters counters[KIND_MAX];
+static atomic_ullong violations[VIOL_MAX];
+static atomic_uint reported;
+static atomic_int stop_flag;
+static atomic_int open_failed;
+
+// Odd while a writer is setting the time, incremented before and after every set
+static atomic_ulong set_gen;
+static pthread_mutex_t writer_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t alarm_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static unsigned int write_period_ms = 1500;
+static unsigned int alarm_period_ms = 500;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static void sleep_ms(unsigned int ms)
+{
+    struct timespec ts = { ms / 1000, (ms % 1000) * 1000000L };
+
+    nanosleep(&ts, NULL);
+}
+
+static void violation(enum stress_violation v, enum stress_kind kind, const char *fmt, ...)
+    __attribute__((format(printf, 3, 4)));
+
+static void violation(enum stress_violation v, enum stress_kind kind, const char *fmt, ...)
+{
+    char msg[256];
+    va_list ap;
+
+    atomic_fetch_add(&violations[v], 1);
+    if (atomic_fetch_add(&reported, 1) >= MAX_REPORTED)
+        return;
+
+    va_start(ap, fmt);
+    vsnprintf(msg, sizeof(msg), fmt, ap);
+    va_end(ap);
+    fprintf(stderr, "VIOLATION %s (%s): %s\n", viol_names[v], kind_names[kind], msg);
+}
+
+// Decode one BCD register, -1 if a digit is not 0-9
+static int bcd_decode(unsigned int v)
+{
+    if (v > 0xFF || (v & 0x0F) > 9 || (v >> 4) > 9)
+        return -1;
+    return (v >> 4) * 10 + (v & 0x0F);
+}
+
+static int days_in_month(int month, int year)
+{
+    static const int days[12] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+
+    if (month == 2 && year % 4 == 0)
+        return 29;
+    return days[month - 1];
+}
+
+static time_t reading_to_time(const struct rtc_reading *r)
+{
+    struct tm tm = {
+        .tm_year = r->year + 100, .tm_mon = r->month - 1, .tm_mday = r->date,
+        .tm_hour = r->hour, .tm_min = r->min, .tm_sec = r->sec,
+    };
+
+    return timegm(&tm);
+}
+
+// Decode and validate BCD time and date registers, 0 if the reading is consistent
+static int check_reading(enum stress_kind kind, const unsigned int raw[7], struct rtc_reading *r)
+{
+    static const char *fields[7] = { "hour", "min", "sec", "day", "date", "month", "year" };
+    int v[7], i;
+    struct tm tm;
+    time_t t;
+
+    for (i = 0; i < 7; i++) {
+        v[i] = bcd_decode(raw[i]);
+        if (v[i] < 0) {
+            violation(VIOL_BCD, kind, "%s register 0x%02x", fields[i], raw[i]);
+            return -1;
+        }
+    }
+    r->hour = v[0]; r->min = v[1]; r->sec = v[2];
+    r->day = v[3]; r->date = v[4]; r->month = v[5]; r->year = v[6];
+
+    if (r->hour > 23 || r->min > 59 || r->sec > 59 || r->day < 1 || r->day > 7 ||
+        r->month < 1 || r->month > 12 || r->date < 1 || r->date > days_in_month(r->month, r->year)) {
+        violation(VIOL_RANGE, kind, "%02d:%02d:%02d %02d/%02d/%02d day %d",
+                  r->hour, r->min, r->sec, r->date, r->month, r->year, r->day);
+        return -1;
+    }
+
+    // The driver and this tool both set the day of week as tm_wday + 1
+    t = reading_to_time(r);
+    gmtime_r(&t, &tm);
+    if (r->day != tm.tm_wday + 1) {
+        violation(VIOL_WEEKDAY, kind, "%02d/%02d/%02d has day %d, expected %d",
+                  r->date, r->month, r->year, r->day, tm.tm_wday + 1);
+        return -1;
+    }
+    return 0;
+}
+
+// Check a reading against the previous one of the same thread. Only readings that started
+// and ended with no set in progress or in between are compared.
+static void check_progress(enum stress_kind kind, struct rtc_track *tr, const struct rtc_reading *r,
+                           unsigned long gen_before, unsigned long gen_after, uint64_t start_ns)
+{
+    uint64_t end_ns = now_ns();
+    time_t t = reading_to_time(r);
+
+    if (gen_before != gen_after || (gen_before & 1) || r->stale) {
+        tr->valid = 0;
+        return;
+    }
+
+    if (tr->valid && tr->gen == gen_before) {
+        // The RTC was sampled somewhere within each read, allow one second of granularity
+        long long elapsed = (long long)((end_ns - tr->start_ns) / 1000000000ull) + 1;
+
+        if (t < tr->t)
+            violation(VIOL_BACKWARDS, kind, "%lld -> %lld (%02d:%02d:%02d %02d/%02d/%02d)",
+                      (long long)tr->t, (long long)t, r->hour, r->min, r->sec, r->date, r->month, r->year);
+        else if (t - tr->t > elapsed)
+            violation(VIOL_JUMP, kind, "advanced %lld s in %lld s (%02d:%02d:%02d %02d/%02d/%02d)",
+                      (long long)(t - tr->t), elapsed, r->hour, r->min, r->sec, r->date, r->month, r->year);
+    }
+
+    tr->valid = 1;
+    tr->gen = gen_before;
+    tr->t = t;
+    tr->start_ns = start_ns;
+}
+
+static int ioctl_read_time(int fd, enum stress_kind kind, struct rtc_reading *r)
+{
+    struct rtc_value v;
+    unsigned int raw[7];
+    int ret;
+
+    ret = ioctl(fd, RD_RTC_TIME, &v);
+    if (ret < 0)
+        return -errno;
+
+    raw[0] = v.usr_hour; raw[1] = v.usr_min; raw[2] = v.usr_sec;
+    raw[3] = v.usr_day; raw[4] = v.usr_date; raw[5] = v.usr_month; raw[6] = v.usr_year;
+    if (check_reading(kind, raw, r) < 0)
+        return 1;
+    r->stale = ret == DS3231_STALE;
+    return 0;
+}
+
+static int read_file(const char *path, char *buf, size_t size)
+{
+    ssize_t len;
+    int fd;
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return -errno;
+    len = read(fd, buf, size - 1);
+    if (len < 0)
+        len = -errno;
+    close(fd);
+    if (len < 0)
+        return len;
+    buf[len] = '\0';
+    return 0;
+}
+
+// Parse the "Current RTC Time/Date" lines shared by sysfs rtc_time and /proc/rtc_time
+static int text_read_time(const char *path, enum stress_kind kind, struct rtc_reading *r)
+{
+    unsigned int raw[7];
+    const char *p;
+    char buf[512];
+    int ret;
+
+    ret = read_file(path, buf, sizeof(buf));
+    if (ret < 0)
+        return ret;
+
+    p = strstr(buf, "Current RTC Time:");
+    if (!p || sscanf(p, "Current RTC Time: %x:%x:%x\nCurrent RTC Date: %x/%x/20%x (Day of Week: %x)",
+                     &raw[0], &raw[1], &raw[2], &raw[4], &raw[5], &raw[6], &raw[3]) != 7) {
+        violation(VIOL_PARSE, kind, "%s: %.80s", path, buf);
+        return 1;
+    }
+    if (kind == KIND_PROC && !strstr(buf, "Alarm1 status: ")) {
+        violation(VIOL_PARSE, kind, "%s: no alarm status", path);
+        return 1;
+    }
+    if (check_reading(kind, raw, r) < 0)
+        return 1;
+    r->stale = strstr(buf, "Stale: yes") != NULL;
+    return 0;
+}
+
+// sysfs alarm_time prints the alarm in BCD
+static int sysfs_read_alarm(enum stress_kind kind)
+{
+    unsigned int h, m, s;
+    char buf[256];
+    int ret;
+
+    ret = read_file(SYSFS_ALM_PATH, buf, sizeof(buf));
+    if (ret < 0)
+        return ret;
+    if (sscanf(buf, "Alarm1 set for: %x:%x:%x", &h, &m, &s) != 3) {
+        violation(VIOL_PARSE, kind, "%s: %.80s", SYSFS_ALM_PATH, buf);
+        return 1;
+    }
+    if (bcd_decode(h) < 0 || bcd_decode(m) < 0 || bcd_decode(s) < 0) {
+        violation(VIOL_BCD, kind, "alarm %02x:%02x:%02x", h, m, s);
+        return 1;
+    }
+    if (bcd_decode(h) > 23 || bcd_decode(m) > 59 || bcd_decode(s) > 59) {
+        violation(VIOL_RANGE, kind, "alarm %02x:%02x:%02x", h, m, s);
+        return 1;
+    }
+    return 0;
+}
+
+static void count_result(enum stress_kind kind, int ret, const struct rtc_reading *r)
+{
+    atomic_fetch_add(&counters[kind].ops, 1);
+    if (ret < 0)
+        atomic_fetch_add(&counters[kind].errors, 1);
+    else if (!ret && r && r->stale)
+        atomic_fetch_add(&counters[kind].stale, 1);
+}
+
+static void *reader_fn(struct stress_thread *t)
+{
+    struct rtc_track track = { 0 };
+    struct rtc_reading r;
+    unsigned long iter = 0;
+    int fd = -1;
+
+    if (t->kind == KIND_IOCTL) {
+        fd = open(DEV_PATH, O_RDWR);
+        if (fd < 0) {
+            perror("Failed to open the device file");
+            atomic_store(&open_failed, 1);
+            return NULL;
+        }
+    }
+
+    while (!atomic_load(&stop_flag)) {
+        unsigned long gen_before, gen_after;
+        uint64_t start;
+        int ret;
+
+        // sysfs readers also poll the alarm attribute every other iteration
+        if (t->kind == KIND_SYSFS && (iter++ & 1)) {
+            ret = sysfs_read_alarm(t->kind);
+            count_result(t->kind, ret, NULL);
+            continue;
+        }
+
+        gen_before = atomic_load(&set_gen);
+        start = now_ns();
+        if (t->kind == KIND_IOCTL)
+            ret = ioctl_read_time(fd, t->kind, &r);
+        else
+            ret = text_read_time(t->kind == KIND_SYSFS ? SYSFS_RTC_PATH : PROC_PATH, t->kind, &r);
+        gen_after = atomic_load(&set_gen);
+
+        count_result(t->kind, ret, &r);
+        if (ret)
+            track.valid = 0;
+        else
+            check_progress(t->kind, &track, &r, gen_before, gen_after, start);
+    }
+
+    if (fd >= 0)
+        close(fd);
+    return NULL;
+}
+
+// Set the time a few seconds before a minute, hour, day, month or year rollover
+static void pick_rollover(unsigned int *seed, struct tm *tm)
+{
+    time_t t;
+
+    memset(tm, 0, sizeof(*tm));
+    tm->tm_year = 120 + rand_r(seed) % 20;
+    tm->tm_mon = rand_r(seed) % 12;
+    tm->tm_mday = 1 + rand_r(seed) % 28;
+    tm->tm_hour = rand_r(seed) % 24;
+    tm->tm_min = 59;
+    tm->tm_sec = 57;
+
+    switch (rand_r(seed) % 5) {
+    case 0:     // Minute
+        tm->tm_min = rand_r(seed) % 59;
+        break;
+    case 1:     // Hour
+        break;
+    case 2:     // Day
+        tm->tm_hour = 23;
+        break;
+    case 3:     // Month, February of leap and common years included
+        tm->tm_hour = 23;
+        tm->tm_mday = days_in_month(tm->tm_mon + 1, tm->tm_year - 100);
+        break;
+    default:    // Year
+        tm->tm_hour = 23;
+        tm->tm_mon = 11;
+        tm->tm_mday = 31;
+        break;
+    }
+
+    // Normalize and fill in the day of week
+    t = timegm(tm);
+    gmtime_r(&t, tm);
+}
+
+// Alternate between the ioctl and sysfs set paths
+static int write_time(int fd, const struct tm *tm, int use_sysfs)
+{
+    char buf[128];
+    ssize_t len;
+    int sfd;
+
+    if (!use_sysfs) {
+        struct rtc_value v = {
+            .usr_hour = tm->tm_hour, .usr_min = tm->tm_min, .usr_sec = tm->tm_sec,
+            .usr_day = tm->tm_wday + 1, .usr_date = tm->tm_mday,
+            .usr_month = tm->tm_mon + 1, .usr_year = tm->tm_year - 100,
+        };
+
+        return ioctl(fd, WR_RTC_TIME, &v) < 0 ? -errno : 0;
+    }
+
+    len = snprintf(buf, sizeof(buf), "set time: %d:%d:%d, set date: %d/%d/%d, day of week: %d",
+                   tm->tm_hour, tm->tm_min, tm->tm_sec, tm->tm_mday, tm->tm_mon + 1,
+                   tm->tm_year - 100, tm->tm_wday + 1);
+    sfd = open(SYSFS_RTC_PATH, O_WRONLY);
+    if (sfd < 0)
+        return -errno;
+    if (write(sfd, buf, len) != len)
+        len = -errno;
+    close(sfd);
+    return len < 0 ? len : 0;
+}
+
+static void *writer_fn(struct stress_thread *t)
+{
+    unsigned int seed = time(NULL) ^ (t->id * 7919);
+    unsigned long iter = 0;
+    struct tm tm;
+    int fd;
+
+    fd = open(DEV_PATH, O_RDWR);
+    if (fd < 0) {
+        perror("Failed to open the device file");
+        atomic_store(&open_failed, 1);
+        return NULL;
+    }
+
+    while (!atomic_load(&stop_flag)) {
+        int ret;
+
+        sleep_ms(write_period_ms / 2 + rand_r(&seed) % (write_period_ms + 1));
+        if (atomic_load(&stop_flag))
+            break;
+        pick_rollover(&seed, &tm);
+
+        pthread_mutex_lock(&writer_lock);
+        atomic_fetch_add(&set_gen, 1);
+        ret = write_time(fd, &tm, iter++ & 1);
+        atomic_fetch_add(&set_gen, 1);
+        pthread_mutex_unlock(&writer_lock);
+
+        count_result(KIND_WRITER, ret, NULL);
+    }
+
+    close(fd);
+    return NULL;
+}
+
+// Set alarm 1 some time ahead through the ioctl and check that it reads back as the RTC
+// time at the moment of the set plus the offset
+static void *alarm_fn(struct stress_thread *t)
+{
+    unsigned int seed = time(NULL) ^ (t->id * 104729);
+    struct rtc_reading before, after;
+    struct alm_value set, got;
+    int fd;
+
+    fd = open(DEV_PATH, O_RDWR);
+    if (fd < 0) {
+        perror("Failed to open the device file");
+        atomic_store(&open_failed, 1);
+        return NULL;
+    }
+
+    while (!atomic_load(&stop_flag)) {
+        unsigned long gen_before, gen_after;
+        long offset, lo, hi, a;
+        int ret;
+
+        sleep_ms(alarm_period_ms / 2 + rand_r(&seed) % (alarm_period_ms + 1));
+        set.alm_hour = rand_r(&seed) % 2;
+        set.alm_min = rand_r(&seed) % 60;
+        set.alm_sec = 1 + rand_r(&seed) % 59;
+        offset = set.alm_hour * 3600 + set.alm_min * 60 + set.alm_sec;
+
+        // Alarm threads are serialized so the read back belongs to this set
+        pthread_mutex_lock(&alarm_lock);
+        gen_before = atomic_load(&set_gen);
+        ret = ioctl_read_time(fd, KIND_ALARM, &before);
+        if (!ret)
+            ret = ioctl(fd, WR_ALM1_TIME, &set) < 0 ? -errno : 0;
+        if (!ret)
+            ret = ioctl_read_time(fd, KIND_ALARM, &after);
+        if (!ret)
+            ret = ioctl(fd, RD_ALM1_TIME, &got) < 0 ? -errno : 0;
+        gen_after = atomic_load(&set_gen);
+        pthread_mutex_unlock(&alarm_lock);
+
+        count_result(KIND_ALARM, ret, NULL);
+        if (ret)
+            continue;
+
+        if (got.alm_hour > 23 || got.alm_min > 59 || got.alm_sec > 59) {
+            violation(VIOL_RANGE, KIND_ALARM, "alarm %02d:%02d:%02d", got.alm_hour, got.alm_min, got.alm_sec);
+            continue;
+        }
+        if (gen_before != gen_after || (gen_before & 1) || before.stale || after.stale)
+            continue;
+
+        // Seconds of the day, the alarm wraps at midnight
+        lo = (before.hour * 3600 + before.min * 60 + before.sec + offset) % 86400;
+        hi = (after.hour * 3600 + after.min * 60 + after.sec + offset) % 86400;
+        a = got.alm_hour * 3600 + got.alm_min * 60 + got.alm_sec;
+        if (lo <= hi ? (a < lo || a > hi) : (a < lo && a > hi))
+            violation(VIOL_ALARM, KIND_ALARM, "set +%lds at %02d:%02d:%02d, read back %02d:%02d:%02d",
+                      offset, before.hour, before.min, before.sec, got.alm_hour, got.alm_min, got.alm_sec);
+    }
+
+    close(fd);
+    return NULL;
+}
+
+static void *stress_thread_fn(void *arg)
+{
+    struct stress_thread *t = arg;
+
+    switch (t->kind) {
+    case KIND_WRITER:
+        return writer_fn(t);
+    case KIND_ALARM:
+        return alarm_fn(t);
+    default:
+        return reader_fn(t);
+    }
+}
+
+static void on_signal(int sig)
+{
+    (void)sig;
+    atomic_store(&stop_flag, 1);
+}
+
+static unsigned long long total_errors(void)
+{
+    unsigned long long total = 0;
+    int k;
+
+    for (k = 0; k < KIND_MAX; k++)
+        total += atomic_load(&counters[k].errors);
+    return total;
+}
+
+static unsigned long long total_violations(void)
+{
+    unsigned long long total = 0;
+    int v;
+
+    for (v = 0; v < VIOL_MAX; v++)
+        total += atomic_load(&violations[v]);
+    return total;
+}
+
+static void print_report(double elapsed, int final)
+{
+    int k, v;
+
+    if (!final) {
+        unsigned long long ops = 0;
+
+        for (k = 0; k < KIND_MAX; k++)
+            ops += atomic_load(&counters[k].ops);
+        printf("[%8.0fs] ops=%llu ops/s=%.0f violations=%llu\n",
+               elapsed, ops, ops / elapsed, total_violations());
+        fflush(stdout);
+        return;
+    }
+
+    printf("%-14s %12s %12s %10s %10s\n", "thread", "ops", "ops/s", "errors", "stale");
+    for (k = 0; k < KIND_MAX; k++) {
+        unsigned long long ops = atomic_load(&counters[k].ops);
+
+        printf("%-14s %12llu %12.1f %10llu %10llu\n", kind_names[k], ops, ops / elapsed,
+               (unsigned long long)atomic_load(&counters[k].errors),
+               (unsigned long long)atomic_load(&counters[k].stale));
+    }
+    printf("violations:");
+    for (v = 0; v < VIOL_MAX; v++)
+        printf(" %s=%llu", viol_names[v], (unsigned long long)atomic_load(&violations[v]));
+    printf("\nelapsed: %.1fs, time sets: %lu\n", elapsed, atomic_load(&set_gen) / 2);
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s [-r readers] [-w writers] [-a alarms] [-d seconds] [-p ms] [-P ms] [-s seconds]\n"
+            "  -r N   reader threads per interface: ioctl, sysfs, proc (default 2)\n"
+            "  -w N   time writer threads (default 1)\n"
+            "  -a N   alarm setting threads (default 1)\n"
+            "  -d S   run for S seconds, 0 runs until interrupted (default 60)\n"
+            "  -p MS  average delay between time sets (default 1500)\n"
+            "  -P MS  average delay between alarm sets (default 500)\n"
+            "  -s S   progress report interval (default 10)\n"
+            "Exits with a non-zero status on any violation or failed operation\n",
+            prog);
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned int readers = 2, writers = 1, alarms = 1;
+    unsigned int duration = 60, report = 10;
+    struct stress_thread *threads;
+    unsigned int nthreads, i, k;
+    uint64_t start, next_report;
+    double elapsed;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "r:w:a:d:p:P:s:h")) != -1) {
+        switch (opt) {
+        case 'r':
+            readers = strtoul(optarg, NULL, 0);
+            break;
+        case 'w':
+            writers = strtoul(optarg, NULL, 0);
+            break;
+        case 'a':
+            alarms = strtoul(optarg, NULL, 0);
+            break;
+        case 'd':
+            duration = strtoul(optarg, NULL, 0);
+            break;
+        case 'p':
+            write_period_ms = strtoul(optarg, NULL, 0);
+            break;
+        case 'P':
+            alarm_period_ms = strtoul(optarg, NULL, 0);
+            break;
+        case 's':
+            report = strtoul(optarg, NULL, 0);
+            break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+
+    nthreads = readers * 3 + writers + alarms;
+    if (!nthreads || !report) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    threads = calloc(nthreads, sizeof(*threads));
+    if (!threads) {
+        perror("calloc");
+        return EXIT_FAILURE;
+    }
+
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    start = now_ns();
+    for (i = 0, k = 0; k < KIND_MAX; k++) {
+        unsigned int n = k == KIND_WRITER ? writers : k == KIND_ALARM ? alarms : readers;
+
+        while (n--) {
+            threads[i].kind = k;
+            threads[i].id = i;
+            if (pthread_create(&threads[i].tid, NULL, stress_thread_fn, &threads[i])) {
+                perror("pthread_create");
+                atomic_store(&stop_flag, 1);
+                break;
+            }
+            i++;
+        }
+    }
+    nthreads = i;
+
+    next_report = start + report * 1000000000ull;
+    while (!atomic_load(&stop_flag)) {
+        uint64_t now;
+
+        sleep_ms(100);
+        now = now_ns();
+        if (duration && now - start >= duration * 1000000000ull)
+            break;
+        if (now >= next_report) {
+            print_report((now - start) / 1e9, 0);
+            next_report += report * 1000000000ull;
+        }
+    }
+    atomic_store(&stop_flag, 1);
+
+    for (i = 0; i < nthreads; i++)
+        pthread_join(threads[i].tid, NULL);
+    elapsed = (now_ns() - start) / 1e9;
+
+    print_report(elapsed, 1);
+    free(threads);
+
+    return total_violations() || total_errors() || open_failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
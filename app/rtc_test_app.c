@@ -4,6 +4,13 @@
 #include <unistd.h>
 #include <sys/ioctl.h>
 #include <errno.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+
+#include "ds3231_lib.h"
 
 struct rtc_value {
     unsigned char usr_hour, usr_min, usr_sec;
@@ -14,34 +21,734 @@ struct alm_value {
     unsigned char alm_hour, alm_min, alm_sec;
 };
 
+struct alm_mode_value {
+    unsigned char alm_mode;
+    unsigned char alm_day, alm_hour, alm_min, alm_sec;
+};
+
+struct alm_abs_value {
+    int64_t alm_time;
+};
+
+struct rtc_status_value {
+    unsigned char ctl, status;
+    int16_t temp_qc;
+    unsigned char alm1_enabled, alm1_repeat;
+};
+
+struct rtc_hr_value {
+    int64_t sec;
+    uint32_t nsec;
+    uint32_t rate;
+};
+
 #define WR_RTC_TIME _IOW('a', 1, struct rtc_value)
 #define RD_RTC_TIME _IOR('a', 2, struct rtc_value)
 #define WR_ALM1_TIME _IOW('a', 3,struct alm_value)
 #define RD_ALM1_TIME _IOR('a', 4, struct alm_value)
+#define WR_ALM1_MODE _IOW('a', 5, struct alm_mode_value)
+#define RD_ALM1_MODE _IOR('a', 6, struct alm_mode_value)
+#define WR_ALM1_ABS _IOW('a', 7, struct alm_abs_value)
+#define RD_ALM1_ABS _IOR('a', 8, struct alm_abs_value)
+#define RD_RTC_STATUS _IOR('a', 9, struct rtc_status_value)
+#define REG_ALM1_EVENTFD _IOW('a', 10, int)
+#define RD_RTC_TIME_HR _IOR('a', 11, struct rtc_hr_value)
+
+// The read ioctls return DS3231_STALE, from ds3231_core.h, when the driver served cached
+// values after a bus failure
+
+// Alarm 1 rates, in the order of the driver's enum ds3231_alarm_mode
+static const char *alm_mode_names[] = { "every second", "seconds match", "minutes:seconds match",
+                                        "hours:minutes:seconds match", "date match", "day of week match" };
+
+/* batch CLI start */
+
+// Command line mode for scripts: any number of commands from argv, or one or more per line
+// from stdin, run against a single open of the device. Each command prints one record, as
+// "cmd key=value ..." or, with -j, as one JSON object per line. Failures print an error record
+// and the remaining commands still run, the exit status is 1 if any of them failed.
+// With --i2c-dev or --mock the commands run through ds3231_core instead of the driver.
+
+static const char *event_names[] = { "unknown", "alarm1", "osf", "time_set" };
+
+// Event record returned by read() on the device file
+struct ds3231_event_rec {
+    uint32_t type;
+    uint32_t seq;
+    int64_t rtc_sec;
+    int64_t realtime_ns;
+    int64_t monotonic_ns;
+    uint8_t status;
+    uint8_t pad[7];
+};
+
+#define DS3231_EVENT_ALARM1 1
+
+static int json_output;
+static int out_fields;
+
+// Set when the commands go to the chip through ds3231_core instead of the driver
+static struct ds3231_transport *core_tr;
+
+static void out_begin(const char *cmd)
+{
+    out_fields = 0;
+    if (json_output)
+        printf("{\"cmd\":\"%s\"", cmd);
+    else
+        printf("%s", cmd);
+}
+
+static void out_str(const char *key, const char *val)
+{
+    if (json_output)
+        printf(",\"%s\":\"%s\"", key, val);
+    else
+        printf(strchr(val, ' ') ? " %s=\"%s\"" : " %s=%s", key, val);
+    out_fields++;
+}
+
+static void out_int(const char *key, long long val)
+{
+    if (json_output)
+        printf(",\"%s\":%lld", key, val);
+    else
+        printf(" %s=%lld", key, val);
+    out_fields++;
+}
+
+// Numeric value already formatted, e.g. with a fraction
+static void out_num(const char *key, const char *val)
+{
+    if (json_output)
+        printf(",\"%s\":%s", key, val);
+    else
+        printf(" %s=%s", key, val);
+    out_fields++;
+}
+
+static void out_hex(const char *key, unsigned int val)
+{
+    char buf[8];
+
+    if (json_output) {
+        out_int(key, val);
+        return;
+    }
+    snprintf(buf, sizeof(buf), "0x%02x", val);
+    out_str(key, buf);
+}
+
+static void out_end(void)
+{
+    if (json_output)
+        printf("}\n");
+    else
+        printf(out_fields ? "\n" : " ok\n");
+    fflush(stdout);
+}
+
+static int out_error(const char *cmd, const char *msg)
+{
+    out_begin(cmd);
+    out_str("error", msg);
+    out_end();
+    return -1;
+}
+
+// "YYYY-MM-DDTHH:MM:SS", "@<seconds since the epoch>" or "now" (host time) to RTC seconds
+static int parse_datetime(const char *s, time_t *t)
+{
+    struct tm tm;
+    char end;
+
+    if (!strcmp(s, "now")) {
+        *t = time(NULL);
+        return 0;
+    }
+    if (s[0] == '@') {
+        long long v;
+
+        if (sscanf(s + 1, "%lld%c", &v, &end) != 1)
+            return -1;
+        *t = v;
+        return 0;
+    }
+    memset(&tm, 0, sizeof(tm));
+    if (sscanf(s, "%d-%d-%dT%d:%d:%d%c", &tm.tm_year, &tm.tm_mon, &tm.tm_mday,
+               &tm.tm_hour, &tm.tm_min, &tm.tm_sec, &end) != 6)
+        return -1;
+    tm.tm_year -= 1900;
+    tm.tm_mon -= 1;
+    *t = timegm(&tm);
+    return 0;
+}
+
+static void format_datetime(time_t t, char *buf, size_t len)
+{
+    struct tm tm;
+
+    gmtime_r(&t, &tm);
+    strftime(buf, len, "%Y-%m-%dT%H:%M:%S", &tm);
+}
 
-// Function to convert BCD to binary
-static unsigned char bcd2bin(unsigned char val)
+static int parse_hms(const char *s, unsigned int *h, unsigned int *m, unsigned int *sec)
 {
-    return ((val >> 4) * 10) + (val & 0x0F);
+    char end;
+
+    return sscanf(s, "%u:%u:%u%c", h, m, sec, &end) == 3 ? 0 : -1;
 }
 
-unsigned char bin2bcd(unsigned char bin)
+static int cmd_get(int fd, char **args)
 {
-    return ((bin / 10) << 4) + (bin % 10);
+    struct ds3231_time tm;
+    char buf[32];
+    int64_t t;
+    int ret;
+
+    if (core_tr) {
+        ret = ds3231_get_time(core_tr, &tm);
+        if (ret < 0)
+            return out_error("get", strerror(-ret));
+    } else {
+        struct rtc_value v;
+
+        ret = ioctl(fd, RD_RTC_TIME, &v);
+        if (ret < 0)
+            return out_error("get", strerror(errno));
+
+        // The driver returns the time and date as the registers hold them, in BCD
+        unsigned char regs[7] = { v.usr_sec, v.usr_min, v.usr_hour, v.usr_day,
+                                  v.usr_date, v.usr_month, v.usr_year };
+        ds3231_decode_time(regs, &tm);
+    }
+
+    t = ds3231_mktime(&tm);
+    format_datetime(t, buf, sizeof(buf));
+
+    out_begin("get");
+    out_str("time", buf);
+    out_int("epoch", (long long)t);
+    out_int("day", tm.day);
+    out_int("stale", ret == DS3231_STALE);
+    out_end();
+    return 0;
 }
 
+// Sub-second time from the driver's square wave count, no bus access
+static int cmd_get_hires(int fd, char **args)
+{
+    struct rtc_hr_value v;
+    char buf[32];
+
+    if (core_tr)
+        return out_error("get-hires", "needs the driver");
+    if (ioctl(fd, RD_RTC_TIME_HR, &v) < 0)
+        return out_error("get-hires", errno == EOPNOTSUPP ? "driver not loaded with hires_rate" :
+                                                            strerror(errno));
+
+    format_datetime(v.sec, buf, sizeof(buf));
+    out_begin("get-hires");
+    out_str("time", buf);
+    snprintf(buf, sizeof(buf), "%lld.%09u", (long long)v.sec, v.nsec);
+    out_num("epoch", buf);
+    out_int("rate", v.rate);
+    out_end();
+    return 0;
+}
+
+static int cmd_set(int fd, char **args)
+{
+    struct ds3231_time tm;
+    time_t t;
+    int ret;
+
+    if (parse_datetime(args[0], &t) < 0)
+        return out_error("set", "expected YYYY-MM-DDTHH:MM:SS, @seconds or now");
+    ds3231_time_to_tm(t, &tm);
+    if (t < 946684800 || tm.year > 99)
+        return out_error("set", "year out of range 2000-2099");
+
+    if (core_tr) {
+        ret = ds3231_set_time(core_tr, &tm);
+        if (ret < 0)
+            return out_error("set", strerror(-ret));
+    } else {
+        struct rtc_value v = {
+            .usr_hour = tm.hour, .usr_min = tm.min, .usr_sec = tm.sec, .usr_day = tm.day,
+            .usr_date = tm.date, .usr_month = tm.month, .usr_year = tm.year,
+        };
+
+        if (ioctl(fd, WR_RTC_TIME, &v) < 0)
+            return out_error("set", strerror(errno));
+    }
+
+    out_begin("set");
+    out_end();
+    return 0;
+}
+
+static int cmd_set_alarm(int fd, char **args)
+{
+    unsigned int h, m, s;
+    int ret = 0;
+
+    if (!strcmp(args[0], "in")) {
+        struct alm_value v;
+
+        if (parse_hms(args[1], &h, &m, &s) < 0 || h > 255 || m > 255 || s > 255)
+            return out_error("set-alarm", "expected in H:M:S");
+        if (core_tr) {
+            int64_t target;
 
-int main() {
+            ret = ds3231_set_alarm1_after(core_tr, h, m, s, &target);
+        } else {
+            v.alm_hour = h;
+            v.alm_min = m;
+            v.alm_sec = s;
+            if (ioctl(fd, WR_ALM1_TIME, &v) < 0)
+                ret = -errno;
+        }
+    } else if (!strcmp(args[0], "at")) {
+        struct alm_abs_value v;
+        time_t t;
+
+        if (parse_datetime(args[1], &t) < 0)
+            return out_error("set-alarm", "expected at YYYY-MM-DDTHH:MM:SS or @seconds");
+        if (core_tr) {
+            ret = ds3231_arm_alarm1_abs(core_tr, t);
+        } else {
+            v.alm_time = t;
+            if (ioctl(fd, WR_ALM1_ABS, &v) < 0)
+                ret = -errno;
+        }
+    } else {
+        unsigned int mode, day;
+
+        for (mode = 0; mode < DS3231_ALM_MODE_MAX; mode++) {
+            if (!strcmp(args[1], ds3231_alarm_mode_names[mode]))
+                break;
+        }
+        if (mode == DS3231_ALM_MODE_MAX ||
+            sscanf(args[2], "%u", &day) != 1 || day > 31 || parse_hms(args[3], &h, &m, &s) < 0)
+            return out_error("set-alarm", "expected mode <name> <day> HH:MM:SS");
+        if (core_tr) {
+            unsigned char alarm[4];
+
+            ret = ds3231_encode_alarm1(mode, day, h, m, s, alarm);
+            if (ret >= 0)
+                ret = ds3231_set_alarm1(core_tr, alarm);
+        } else {
+            struct alm_mode_value v = { .alm_mode = mode, .alm_day = day, .alm_hour = h,
+                                        .alm_min = m, .alm_sec = s };
+
+            if (ioctl(fd, WR_ALM1_MODE, &v) < 0)
+                ret = -errno;
+        }
+    }
+    if (ret < 0)
+        return out_error("set-alarm", strerror(-ret));
+
+    out_begin("set-alarm");
+    // Without the driver nobody re-arms an intermediate alarm, the caller has to run again
+    if (ret == 1)
+        out_int("intermediate", 1);
+    out_end();
+    return 0;
+}
+
+// Block on driver events, args[0] is the number of alarms to wait for (0: forever) and
+// args[1] the timeout in seconds (0: none)
+static int cmd_watch(int fd, char **args)
+{
+    struct ds3231_event_rec ev[16];
+    unsigned long count = args[0] ? strtoul(args[0], NULL, 10) : 0;
+    unsigned long timeout = args[1] ? strtoul(args[1], NULL, 10) : 0;
+    unsigned long alarms = 0;
+    struct timespec deadline, now;
+    ssize_t len;
+    int i;
+
+    if (core_tr)
+        return out_error("watch-alarms", "needs the driver");
+
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += timeout;
+
+    while (!count || alarms < count) {
+        if (timeout) {
+            struct pollfd pfd = { .fd = fd, .events = POLLIN };
+            long ms;
+            int ret;
+
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            ms = (deadline.tv_sec - now.tv_sec) * 1000 + (deadline.tv_nsec - now.tv_nsec) / 1000000;
+            ret = poll(&pfd, 1, ms > 0 ? ms : 0);
+            if (ret < 0 && errno != EINTR)
+                return out_error("watch-alarms", strerror(errno));
+            if (ret == 0)
+                return out_error("watch-alarms", "timeout");
+            if (ret < 0)
+                continue;
+        }
+
+        len = read(fd, ev, sizeof(ev));
+        if (len < 0) {
+            if (errno == EINTR || errno == EAGAIN)
+                continue;
+            return out_error("watch-alarms", strerror(errno));
+        }
+
+        for (i = 0; i < len / (ssize_t)sizeof(ev[0]); i++) {
+            out_begin("event");
+            out_int("seq", ev[i].seq);
+            out_str("type", ev[i].type < sizeof(event_names) / sizeof(event_names[0]) ?
+                            event_names[ev[i].type] : "unknown");
+            out_int("rtc_sec", ev[i].rtc_sec);
+            out_int("realtime_ns", ev[i].realtime_ns);
+            out_int("monotonic_ns", ev[i].monotonic_ns);
+            out_hex("status", ev[i].status);
+            out_end();
+            if (ev[i].type == DS3231_EVENT_ALARM1)
+                alarms++;
+        }
+    }
+    return 0;
+}
+
+// Status through ds3231_core, the alarm state the driver keeps is not available
+static int core_dump_status(void)
+{
+    struct ds3231_status st;
+    unsigned char alarm[4];
+    unsigned int day, h, m, s;
+    char buf[32];
+    int mode, ret;
+
+    ret = ds3231_get_status(core_tr, &st);
+    if (ret >= 0)
+        ret = ds3231_get_alarm1(core_tr, alarm);
+    if (ret < 0)
+        return out_error("dump-status", strerror(-ret));
+
+    out_begin("dump-status");
+    out_hex("ctl", st.ctl);
+    out_hex("status", st.status);
+    out_int("osf", !!(st.status & RTC_STAT_BIT_OSF));
+    out_int("a1f", !!(st.status & RTC_STAT_BIT_A1F));
+    snprintf(buf, sizeof(buf), "%.2f", st.temp_qc / 4.0);
+    out_num("temp_c", buf);
+    out_int("alarm1_enabled", !!(st.ctl & RTC_CTL_BIT_A1IE));
+    mode = ds3231_decode_alarm1(alarm, &day, &h, &m, &s);
+    if (mode >= 0) {
+        snprintf(buf, sizeof(buf), "%02u:%02u:%02u", h, m, s);
+        out_str("alarm1_time", buf);
+        out_str("alarm1_mode", ds3231_alarm_mode_names[mode]);
+        out_int("alarm1_day", day);
+    }
+    out_end();
+    return 0;
+}
+
+static int cmd_dump_status(int fd, char **args)
+{
+    struct rtc_status_value st;
+    struct alm_value alm;
+    struct alm_mode_value mode;
+    struct alm_abs_value abs;
+    char buf[32];
+    int stale = 0, ret;
+
+    if (core_tr)
+        return core_dump_status();
+
+    ret = ioctl(fd, RD_RTC_STATUS, &st);
+    if (ret < 0)
+        return out_error("dump-status", strerror(errno));
+    stale |= ret == DS3231_STALE;
+
+    out_begin("dump-status");
+    out_hex("ctl", st.ctl);
+    out_hex("status", st.status);
+    out_int("osf", !!(st.status & RTC_STAT_BIT_OSF));
+    out_int("a1f", !!(st.status & RTC_STAT_BIT_A1F));
+    snprintf(buf, sizeof(buf), "%.2f", st.temp_qc / 4.0);
+    out_num("temp_c", buf);
+    out_int("alarm1_enabled", st.alm1_enabled);
+    out_int("alarm1_repeat", st.alm1_repeat);
+
+    ret = ioctl(fd, RD_ALM1_TIME, &alm);
+    if (ret >= 0) {
+        snprintf(buf, sizeof(buf), "%02u:%02u:%02u", alm.alm_hour, alm.alm_min, alm.alm_sec);
+        out_str("alarm1_time", buf);
+        stale |= ret == DS3231_STALE;
+    }
+    ret = ioctl(fd, RD_ALM1_MODE, &mode);
+    if (ret >= 0 && mode.alm_mode < DS3231_ALM_MODE_MAX) {
+        out_str("alarm1_mode", ds3231_alarm_mode_names[mode.alm_mode]);
+        out_int("alarm1_day", mode.alm_day);
+        stale |= ret == DS3231_STALE;
+    }
+    if (ioctl(fd, RD_ALM1_ABS, &abs) >= 0) {
+        if (abs.alm_time)
+            format_datetime(abs.alm_time, buf, sizeof(buf));
+        out_str("alarm1_at", abs.alm_time ? buf : "none");
+    }
+    out_int("stale", stale);
+    out_end();
+    return 0;
+}
+
+struct cli_cmd {
+    const char *name;
+    int (*fn)(int fd, char **args);
+};
+
+// Same as watch-alarms through an eventfd the driver signals on each alarm. Each record
+// carries the number of alarms since the previous one, more than 1 if wakeups merged.
+static int cmd_watch_eventfd(int fd, char **args)
+{
+    unsigned long count = args[0] ? strtoul(args[0], NULL, 10) : 0;
+    unsigned long timeout = args[1] ? strtoul(args[1], NULL, 10) : 0;
+    unsigned long alarms = 0;
+    struct timespec deadline, now;
+    uint64_t n;
+    int efd, off = -1, ret = 0;
+
+    if (core_tr)
+        return out_error("watch-eventfd", "needs the driver");
+
+    efd = eventfd(0, EFD_CLOEXEC);
+    if (efd < 0)
+        return out_error("watch-eventfd", strerror(errno));
+    if (ioctl(fd, REG_ALM1_EVENTFD, &efd) < 0) {
+        ret = out_error("watch-eventfd", strerror(errno));
+        close(efd);
+        return ret;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += timeout;
+
+    while (!count || alarms < count) {
+        struct pollfd pfd = { .fd = efd, .events = POLLIN };
+        long ms = -1;
+
+        if (timeout) {
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            ms = (deadline.tv_sec - now.tv_sec) * 1000 + (deadline.tv_nsec - now.tv_nsec) / 1000000;
+            if (ms < 0)
+                ms = 0;
+        }
+        ret = poll(&pfd, 1, ms);
+        if (ret < 0 && errno == EINTR)
+            continue;
+        if (ret <= 0) {
+            ret = out_error("watch-eventfd", ret ? strerror(errno) : "timeout");
+            break;
+        }
+        ret = 0;
+        if (read(efd, &n, sizeof(n)) != sizeof(n))
+            continue;
+
+        out_begin("alarm");
+        out_int("count", n);
+        out_end();
+        alarms += n;
+    }
+
+    ioctl(fd, REG_ALM1_EVENTFD, &off);
+    close(efd);
+    return ret;
+}
+
+static const struct cli_cmd cli_cmds[] = {
+    { "get",          cmd_get },
+    { "get-hires",    cmd_get_hires },
+    { "set",          cmd_set },
+    { "set-alarm",    cmd_set_alarm },
+    { "watch-alarms", cmd_watch },
+    { "watch",        cmd_watch },
+    { "watch-eventfd", cmd_watch_eventfd },
+    { "dump-status",  cmd_dump_status },
+};
+
+static int is_number(const char *s)
+{
+    return *s && strspn(s, "0123456789") == strlen(s);
+}
+
+// Number of arguments the command starting at tok[0] takes, or -1 if they are missing
+static int cli_nargs(const char *cmd, char **tok, int n)
+{
+    int i;
+
+    if (!strcmp(cmd, "set"))
+        return n >= 1 ? 1 : -1;
+    if (!strcmp(cmd, "set-alarm")) {
+        if (n >= 2 && (!strcmp(tok[0], "in") || !strcmp(tok[0], "at")))
+            return 2;
+        if (n >= 4 && !strcmp(tok[0], "mode"))
+            return 4;
+        return -1;
+    }
+    if (!strcmp(cmd, "watch-alarms") || !strcmp(cmd, "watch") || !strcmp(cmd, "watch-eventfd")) {
+        // Optional count and timeout
+        for (i = 0; i < 2 && i < n && is_number(tok[i]); i++)
+            ;
+        return i;
+    }
+    return 0;
+}
+
+// Run the commands in tok[0..n-1], returns the number that failed
+static int cli_run(int fd, char **tok, int n)
+{
+    char *args[4];
+    int failed = 0;
+    int i = 0, nargs;
+    size_t c;
+
+    while (i < n) {
+        for (c = 0; c < sizeof(cli_cmds) / sizeof(cli_cmds[0]); c++) {
+            if (!strcmp(tok[i], cli_cmds[c].name))
+                break;
+        }
+        if (c == sizeof(cli_cmds) / sizeof(cli_cmds[0])) {
+            out_error(tok[i], "unknown command");
+            return failed + 1;
+        }
+
+        nargs = cli_nargs(tok[i], tok + i + 1, n - i - 1);
+        if (nargs < 0) {
+            out_error(tok[i], "missing arguments");
+            return failed + 1;
+        }
+        memset(args, 0, sizeof(args));
+        memcpy(args, tok + i + 1, nargs * sizeof(char *));
+        if (cli_cmds[c].fn(fd, args) < 0)
+            failed++;
+        i += 1 + nargs;
+    }
+    return failed;
+}
+
+// Commands from stdin, whitespace separated, '#' starts a comment
+static int cli_run_stdin(int fd)
+{
+    char line[1024], *tok[64], *p;
+    int failed = 0, n;
+
+    while (fgets(line, sizeof(line), stdin)) {
+        if ((p = strchr(line, '#')))
+            *p = '\0';
+        n = 0;
+        for (p = strtok(line, " \t\r\n"); p && n < 64; p = strtok(NULL, " \t\r\n"))
+            tok[n++] = p;
+        failed += cli_run(fd, tok, n);
+    }
+    return failed;
+}
+
+static void cli_usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s                                      interactive menu\n"
+            "       %s [-j] [--i2c-dev <dev>|--mock] <command>...  run commands\n"
+            "       %s [-j] [--i2c-dev <dev>|--mock] -             run commands read from stdin\n"
+            "  -j               print one JSON object per line instead of key=value records\n"
+            "  --i2c-dev <dev>  talk to the chip through an i2c-dev adapter such as /dev/i2c-2,\n"
+            "                   no module needed\n"
+            "  --mock           run against an in-memory register file\n"
+            "Commands:\n"
+            "  get                                  read the time and date\n"
+            "  get-hires                            sub-second time, driver loaded with hires_rate\n"
+            "  set <time>                           set the time and date\n"
+            "  set-alarm in <H:M:S>                 one-shot alarm after a delay\n"
+            "  set-alarm at <time>                  one-shot alarm at an absolute time\n"
+            "  set-alarm mode <name> <day> <H:M:S>  recurring alarm, name is one of\n"
+            "                                       every_second, sec, min_sec, hms, date, day\n"
+            "  watch-alarms [count [timeout]]       print driver events until count alarms\n"
+            "                                       fired (0: forever) or timeout seconds passed\n"
+            "  watch-eventfd [count [timeout]]      the same through an eventfd, one record per\n"
+            "                                       wakeup with the number of alarms\n"
+            "  dump-status                          registers, temperature and alarm 1 state\n"
+            "<time> is YYYY-MM-DDTHH:MM:SS, @<seconds since the epoch> or now (host UTC time)\n",
+            prog, prog, prog);
+}
+
+/* batch CLI end */
+
+
+int main(int argc, char *argv[]) {
     int fd;
     int choice;
+    int failed;
     struct rtc_value rtc_data;
     struct alm_value alm_data;
+    struct alm_mode_value mode_data;
+    struct alm_abs_value abs_data;
+    struct tm tm;
+    time_t t;
+    const char *prog = argv[0];
+    const char *i2c_dev = NULL;
+    struct ds3231_transport tr;
+    struct ds3231_mock mock;
 
-    printf("Opening RTC Driver...\n");
-    fd = open("/dev/DS3231", O_RDWR);
-    if(fd < 0) {
-        perror("Failed to open the device file");
-        return errno;
+    while (argc > 1) {
+        if (!strcmp(argv[1], "-j")) {
+            json_output = 1;
+        } else if (!strcmp(argv[1], "--i2c-dev") && argc > 2) {
+            i2c_dev = argv[2];
+            core_tr = &tr;
+            argc--;
+            argv++;
+        } else if (!strcmp(argv[1], "--mock")) {
+            ds3231_mock_init(&mock, &tr);
+            core_tr = &tr;
+        } else {
+            break;
+        }
+        argc--;
+        argv++;
+    }
+    if (argc > 1 && (!strcmp(argv[1], "-h") || !strcmp(argv[1], "--help"))) {
+        cli_usage(prog);
+        return EXIT_SUCCESS;
+    }
+    // Options only apply to commands, the menu needs the driver
+    if (argc == 1 && prog != argv[0]) {
+        cli_usage(prog);
+        return EXIT_FAILURE;
+    }
+
+    if (core_tr) {
+        fd = -1;
+        if (i2c_dev && (errno = -ds3231_i2cdev_open(&tr, i2c_dev))) {
+            perror("Failed to open the i2c adapter");
+            return errno;
+        }
+    } else {
+        // Command line mode opens the device once and stays quiet apart from the records
+        if (argc == 1)
+            printf("Opening RTC Driver...\n");
+        fd = open("/dev/DS3231", O_RDWR);
+        if(fd < 0) {
+            perror("Failed to open the device file");
+            return errno;
+        }
+    }
+
+    if (argc > 1) {
+        if (argc == 2 && !strcmp(argv[1], "-"))
+            failed = cli_run_stdin(fd);
+        else
+            failed = cli_run(fd, argv + 1, argc - 1);
+        if (i2c_dev)
+            ds3231_i2cdev_close(&tr);
+        else if (!core_tr)
+            close(fd);
+        return failed ? EXIT_FAILURE : EXIT_SUCCESS;
     }
 
     while(1) {
@@ -51,7 +758,11 @@ int main() {
         printf("2. Write RTC Time\n");
         printf("3. Read Alarm 1 Time\n");
         printf("4. Write Alarm 1 Time\n");
-        printf("5. Exit\n");
+        printf("5. Read Alarm 1 Mode\n");
+        printf("6. Write Alarm 1 Mode\n");
+        printf("7. Read Alarm 1 Absolute Time\n");
+        printf("8. Write Alarm 1 Absolute Time\n");
+        printf("9. Exit\n");
         printf("Enter your choice: ");
         scanf("%d", &choice);
 
@@ -96,7 +807,7 @@ int main() {
                     break;
                 }
 
-		printf("Alarm 1 Time: %02x:%02x:%02x\n", bin2bcd(alm_data.alm_hour), bin2bcd(alm_data.alm_min), bin2bcd(alm_data.alm_sec));
+		printf("Alarm 1 Time: %02x:%02x:%02x\n", ds3231_bin2bcd(alm_data.alm_hour), ds3231_bin2bcd(alm_data.alm_min), ds3231_bin2bcd(alm_data.alm_sec));
                 
 		break;
             
@@ -113,7 +824,67 @@ int main() {
                
 	       	break;
             
-	    case 5: // Exit
+	    case 5: // Read Alarm 1 Mode
+
+		if(ioctl(fd, RD_ALM1_MODE, &mode_data) < 0) {
+                    perror("Failed to read Alarm 1 mode");
+                    break;
+                }
+
+		printf("Alarm 1 Mode: %s, day: %u, time: %02u:%02u:%02u\n", alm_mode_names[mode_data.alm_mode],
+		       mode_data.alm_day, mode_data.alm_hour, mode_data.alm_min, mode_data.alm_sec);
+
+		break;
+
+	    case 6: // Write Alarm 1 Mode
+
+		printf("Modes: 0 every second, 1 seconds, 2 minutes:seconds, 3 hours:minutes:seconds, 4 date, 5 day of week\n");
+		printf("Enter mode, day and time (mode day hh mm ss): ");
+
+                scanf("%hhu %hhu %hhu %hhu %hhu", &mode_data.alm_mode, &mode_data.alm_day,
+                      &mode_data.alm_hour, &mode_data.alm_min, &mode_data.alm_sec);
+
+		if(ioctl(fd, WR_ALM1_MODE, &mode_data) < 0) {
+                    perror("Failed to write Alarm 1 mode");
+                }
+
+	       	break;
+
+	    case 7: // Read Alarm 1 Absolute Time
+
+		if(ioctl(fd, RD_ALM1_ABS, &abs_data) < 0) {
+                    perror("Failed to read Alarm 1 absolute time");
+                    break;
+                }
+
+		if (!abs_data.alm_time) {
+		    printf("No absolute alarm set\n");
+		    break;
+		}
+		t = abs_data.alm_time;
+		gmtime_r(&t, &tm);
+		printf("Alarm 1 Absolute Time: %04d-%02d-%02d %02d:%02d:%02d\n", tm.tm_year + 1900, tm.tm_mon + 1,
+		       tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec);
+
+		break;
+
+	    case 8: // Write Alarm 1 Absolute Time
+
+		memset(&tm, 0, sizeof(tm));
+		printf("Enter alarm date and time in RTC time (yyyy mm dd hh mm ss): ");
+
+                scanf("%d %d %d %d %d %d", &tm.tm_year, &tm.tm_mon, &tm.tm_mday, &tm.tm_hour, &tm.tm_min, &tm.tm_sec);
+		tm.tm_year -= 1900;
+		tm.tm_mon -= 1;
+		abs_data.alm_time = timegm(&tm);
+
+		if(ioctl(fd, WR_ALM1_ABS, &abs_data) < 0) {
+                    perror("Failed to write Alarm 1 absolute time");
+                }
+
+	       	break;
+
+	    case 9: // Exit
                 printf("Closing RTC Driver\n");
                 close(fd);
            	return 0;
@@ -0,0 +1,608 @@
+// DS3231 register logic shared by the kernel module and the userspace library, see ds3231_core.h
+#include "ds3231_core.h"
+
+#ifdef __KERNEL__
+#include <linux/errno.h>
+#include <linux/math64.h>
+#include <linux/string.h>
+#else
+#include <errno.h>
+#include <string.h>
+
+static inline int64_t div_s64_rem(int64_t dividend, int32_t divisor, int32_t *remainder)
+{
+    *remainder = dividend % divisor;
+    return dividend / divisor;
+}
+#endif
+
+// Mask bits of the seconds, minutes, hours and day/date alarm registers for each mode
+const unsigned char ds3231_alarm_masks[DS3231_ALM_MODE_MAX][4] = {
+    [DS3231_ALM_EVERY_SECOND] = { RTC_A1M1, RTC_A1M2, RTC_A1M3, RTC_A1M4 },
+    [DS3231_ALM_MATCH_SEC]    = { 0,        RTC_A1M2, RTC_A1M3, RTC_A1M4 },
+    [DS3231_ALM_MATCH_MIN_SEC] = { 0,       0,        RTC_A1M3, RTC_A1M4 },
+    [DS3231_ALM_MATCH_HMS]    = { 0,        0,        0,        RTC_A1M4 },
+    [DS3231_ALM_MATCH_DATE]   = { 0,        0,        0,        0 },
+    [DS3231_ALM_MATCH_DAY]    = { 0,        0,        0,        RTC_A1_DYDT },
+};
+
+const char * const ds3231_alarm_mode_names[DS3231_ALM_MODE_MAX] = {
+    [DS3231_ALM_EVERY_SECOND]  = "every_second",
+    [DS3231_ALM_MATCH_SEC]     = "sec",
+    [DS3231_ALM_MATCH_MIN_SEC] = "min_sec",
+    [DS3231_ALM_MATCH_HMS]     = "hms",
+    [DS3231_ALM_MATCH_DATE]    = "date",
+    [DS3231_ALM_MATCH_DAY]     = "day",
+};
+
+const struct ds3231_op_budget ds3231_budgets[DS3231_OP_MAX] = {
+    [DS3231_OP_INIT]                   = { "init",                   10, 39, RTC_TIME_REGS },
+    [DS3231_OP_IOCTL_RD_TIME]          = { "ioctl_rd_time",           2, 20, RTC_TIME_REGS },
+    [DS3231_OP_IOCTL_WR_TIME]          = { "ioctl_wr_time",           1,  8, 0 },
+    [DS3231_OP_IOCTL_RD_ALARM1]        = { "ioctl_rd_alarm1",         2, 20, RTC_ALM1_REGS },
+    [DS3231_OP_IOCTL_WR_ALARM1]        = { "ioctl_wr_alarm1",         5, 29, RTC_TIME_REGS | RTC_CTL_STAT_REGS },
+    [DS3231_OP_IOCTL_RD_ALM1_MODE]     = { "ioctl_rd_alm1_mode",      2, 20, RTC_ALM1_REGS },
+    [DS3231_OP_IOCTL_WR_ALM1_MODE]     = { "ioctl_wr_alm1_mode",      5, 29, RTC_CTL_STAT_REGS },
+    [DS3231_OP_IOCTL_RD_ALM1_ABS]      = { "ioctl_rd_alm1_abs",       0,  0, 0 },
+    [DS3231_OP_IOCTL_WR_ALM1_ABS]      = { "ioctl_wr_alm1_abs",       5, 29, RTC_TIME_REGS | RTC_CTL_STAT_REGS },
+    [DS3231_OP_IOCTL_RD_STATUS]        = { "ioctl_rd_status",         2, 20, RTC_REGS_MASK(RTC_CTL_REG_ADDR, RTC_NR_REGS - RTC_CTL_REG_ADDR) },
+    [DS3231_OP_SYSFS_RTC_SHOW]         = { "sysfs_rtc_show",          2, 20, RTC_TIME_REGS },
+    [DS3231_OP_SYSFS_RTC_STORE]        = { "sysfs_rtc_store",         1,  8, 0 },
+    [DS3231_OP_SYSFS_ALARM_SHOW]       = { "sysfs_alarm_show",        2, 20, RTC_ALM1_REGS },
+    [DS3231_OP_SYSFS_ALARM_STORE]      = { "sysfs_alarm_store",       5, 29, RTC_TIME_REGS | RTC_CTL_STAT_REGS },
+    [DS3231_OP_SYSFS_ALARM_MODE_SHOW]  = { "sysfs_alarm_mode_show",   2, 20, RTC_ALM1_REGS },
+    [DS3231_OP_SYSFS_ALARM_MODE_STORE] = { "sysfs_alarm_mode_store",  5, 29, RTC_CTL_STAT_REGS },
+    [DS3231_OP_SYSFS_ALARM_AT_SHOW]    = { "sysfs_alarm_at_show",     0,  0, 0 },
+    [DS3231_OP_SYSFS_ALARM_AT_STORE]   = { "sysfs_alarm_at_store",    5, 29, RTC_TIME_REGS | RTC_CTL_STAT_REGS },
+    [DS3231_OP_PROC_READ]              = { "proc_read",               2, 20, RTC_TIME_REGS },
+    [DS3231_OP_ALARM_IRQ]              = { "alarm_irq",               3, 22, RTC_TIME_REGS | RTC_CTL_STAT_REGS },
+    [DS3231_OP_ALARM_REARM]            = { "alarm_rearm",             5, 29, RTC_TIME_REGS | RTC_CTL_STAT_REGS },
+    [DS3231_OP_DRIFT_SAMPLE]           = { "drift_sample",            2, 20, RTC_TIME_REGS | RTC_STAT_REGS | RTC_TEMP_REGS },
+    [DS3231_OP_PM_SUSPEND]             = { "pm_suspend",              3, 22, RTC_CTL_STAT_REGS },
+    [DS3231_OP_PM_RESUME]              = { "pm_resume",               3, 22, RTC_CTL_STAT_REGS },
+    [DS3231_OP_HIRES_RATE]             = { "hires_rate",              3, 22, RTC_CTL_STAT_REGS },
+};
+
+/* encoding start */
+
+// Days since 1970-01-01 of a proleptic Gregorian date, month 1-12
+static int32_t days_from_civil(int32_t y, unsigned int m, unsigned int d)
+{
+    int32_t era;
+    unsigned int yoe, doy, doe;
+
+    y -= m <= 2;
+    era = (y >= 0 ? y : y - 399) / 400;
+    yoe = y - era * 400;
+    doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (int32_t)doe - 719468;
+}
+
+// RTC time in seconds since the epoch, the day of the week is not used
+int64_t ds3231_mktime(const struct ds3231_time *tm)
+{
+    int32_t days = days_from_civil(2000 + tm->year, tm->month, tm->date);
+
+    return (int64_t)days * 86400 + tm->hour * 3600 + tm->min * 60 + tm->sec;
+}
+
+void ds3231_time_to_tm(int64_t t, struct ds3231_time *tm)
+{
+    int32_t rem, days, era, y;
+    unsigned int doe, yoe, doy, mp;
+
+    days = div_s64_rem(t, 86400, &rem);
+    if (rem < 0) {
+        rem += 86400;
+        days--;
+    }
+    tm->hour = rem / 3600;
+    tm->min = rem / 60 % 60;
+    tm->sec = rem % 60;
+    // 1970-01-01 was a Thursday
+    tm->day = (days % 7 + 11) % 7 + 1;
+
+    days += 719468;
+    era = (days >= 0 ? days : days - 146096) / 146097;
+    doe = days - era * 146097;
+    yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    mp = (5 * doy + 2) / 153;
+    tm->date = doy - (153 * mp + 2) / 5 + 1;
+    tm->month = mp < 10 ? mp + 3 : mp - 9;
+    y = (int32_t)yoe + era * 400 + (tm->month <= 2);
+    tm->year = y - 2000;
+}
+
+// Decode the time registers 0x00-0x06, the century bit of the month register is ignored
+void ds3231_decode_time(const unsigned char regs[7], struct ds3231_time *tm)
+{
+    tm->sec = ds3231_bcd2bin(regs[RTC_SEC_REG_ADDR] & 0x7F);
+    tm->min = ds3231_bcd2bin(regs[RTC_MIN_REG_ADDR]);
+    tm->hour = ds3231_bcd2bin(regs[RTC_HR_REG_ADDR] & 0x3F);
+    tm->day = ds3231_bcd2bin(regs[RTC_DAY_REG_ADDR]);
+    tm->date = ds3231_bcd2bin(regs[RTC_DATE_REG_ADDR]);
+    tm->month = ds3231_bcd2bin(regs[RTC_MON_REG_ADDR] & 0x1F);
+    tm->year = ds3231_bcd2bin(regs[RTC_YR_REG_ADDR]);
+}
+
+int64_t ds3231_regs_to_time(const unsigned char regs[7])
+{
+    struct ds3231_time tm;
+
+    ds3231_decode_time(regs, &tm);
+    return ds3231_mktime(&tm);
+}
+
+void ds3231_encode_time(const struct ds3231_time *tm, unsigned char regs[7])
+{
+    regs[RTC_SEC_REG_ADDR] = ds3231_bin2bcd(tm->sec);
+    regs[RTC_MIN_REG_ADDR] = ds3231_bin2bcd(tm->min);
+    regs[RTC_HR_REG_ADDR] = ds3231_bin2bcd(tm->hour);
+    regs[RTC_DAY_REG_ADDR] = ds3231_bin2bcd(tm->day);
+    regs[RTC_DATE_REG_ADDR] = ds3231_bin2bcd(tm->date);
+    regs[RTC_MON_REG_ADDR] = ds3231_bin2bcd(tm->month);
+    regs[RTC_YR_REG_ADDR] = ds3231_bin2bcd(tm->year);
+}
+
+// Temperature registers 0x11-0x12 to 0.25 C steps
+int ds3231_decode_temp(const unsigned char regs[2])
+{
+    return ((signed char)regs[0] * 4) | (regs[1] >> 6);
+}
+
+// Alarm 1 registers for a mode, arguments in binary. day is the date (1-31) for
+// DS3231_ALM_MATCH_DATE and the day of week (1-7) for DS3231_ALM_MATCH_DAY, fields the mode
+// ignores are not checked.
+int ds3231_encode_alarm1(unsigned int mode, unsigned int day, unsigned int hour, unsigned int min,
+                         unsigned int sec, unsigned char alarm[4])
+{
+    const unsigned char *mask;
+
+    if (mode >= DS3231_ALM_MODE_MAX)
+        return -EINVAL;
+    mask = ds3231_alarm_masks[mode];
+
+    if ((!mask[0] && sec > 59) || (!mask[1] && min > 59) || (!mask[2] && hour > 23) ||
+        (mode == DS3231_ALM_MATCH_DATE && (day < 1 || day > 31)) ||
+        (mode == DS3231_ALM_MATCH_DAY && (day < 1 || day > 7)))
+        return -EINVAL;
+
+    // Values of masked fields are ignored by the chip, keep them in range anyway
+    alarm[0] = ds3231_bin2bcd(sec % 60) | mask[0];
+    alarm[1] = ds3231_bin2bcd(min % 60) | mask[1];
+    alarm[2] = ds3231_bin2bcd(hour % 24) | mask[2];
+    alarm[3] = (mode >= DS3231_ALM_MATCH_DATE ? ds3231_bin2bcd(day) : 1) | mask[3];
+    return 0;
+}
+
+// Mode of the alarm 1 registers, -EINVAL for a mask combination the chip does not define
+int ds3231_decode_alarm1(const unsigned char alarm[4], unsigned int *day, unsigned int *hour,
+                         unsigned int *min, unsigned int *sec)
+{
+    // DY/DT is don't care while A1M4 is set
+    unsigned char mask3 = (alarm[3] & RTC_A1M4) ? RTC_A1M4 : (alarm[3] & RTC_A1_DYDT);
+    unsigned int mode;
+
+    for (mode = 0; mode < DS3231_ALM_MODE_MAX; mode++) {
+        const unsigned char *mask = ds3231_alarm_masks[mode];
+
+        if ((alarm[0] & RTC_A1M1) == mask[0] && (alarm[1] & RTC_A1M2) == mask[1] &&
+            (alarm[2] & RTC_A1M3) == mask[2] && mask3 == mask[3])
+            break;
+    }
+    if (mode == DS3231_ALM_MODE_MAX)
+        return -EINVAL;
+
+    *sec = ds3231_bcd2bin(alarm[0] & 0x7F);
+    *min = ds3231_bcd2bin(alarm[1] & 0x7F);
+    *hour = ds3231_bcd2bin(alarm[2] & 0x3F);
+    *day = ds3231_bcd2bin(alarm[3] & 0x3F);
+    return mode;
+}
+
+// Alarm 1 registers for the next step towards an absolute RTC time. Targets less than a day
+// away use the time match and targets later in the current month the date match. Anything
+// further out gets an intermediate alarm at midnight on the 1st of the next month, to be
+// re-armed when it fires. Returns 0 for the final alarm, 1 for an intermediate one, -EINVAL
+// for a target in the past or beyond what the RTC keeps (2000-2099).
+int ds3231_plan_alarm1_abs(int64_t now, int64_t target, unsigned char alarm[4])
+{
+    static const struct ds3231_time end = { .date = 1, .month = 1, .year = 100 };
+    struct ds3231_time now_tm, tm;
+
+    if (target <= now || target >= ds3231_mktime(&end))
+        return -EINVAL;
+
+    ds3231_time_to_tm(now, &now_tm);
+    ds3231_time_to_tm(target, &tm);
+
+    if (target - now < 24 * 3600)
+        return ds3231_encode_alarm1(DS3231_ALM_MATCH_HMS, 0, tm.hour, tm.min, tm.sec, alarm);
+    if (tm.year == now_tm.year && tm.month == now_tm.month)
+        return ds3231_encode_alarm1(DS3231_ALM_MATCH_DATE, tm.date, tm.hour, tm.min, tm.sec, alarm);
+
+    // Intermediate alarm: 00:00:00 on date 1 is the start of the next month
+    ds3231_encode_alarm1(DS3231_ALM_MATCH_DATE, 1, 0, 0, 0, alarm);
+    return 1;
+}
+
+/* encoding end */
+
+/* register sequences start */
+
+// Default settings, the time is left to the caller
+int ds3231_init_chip(const struct ds3231_transport *tr)
+{
+    unsigned char val = 0, sec;
+    int ret;
+
+    // Clear control register
+    ret = tr->write(tr->ctx, RTC_CTL_REG_ADDR, &val, 1);
+    if (ret < 0)
+        return ret;
+
+    // Clear status register
+    ret = tr->write(tr->ctx, RTC_STAT_REG_ADDR, &val, 1);
+    if (ret < 0)
+        return ret;
+
+    // Enable oscillator without clearing the seconds register
+    ret = tr->read(tr->ctx, RTC_SEC_REG_ADDR, &sec, 1);
+    if (ret < 0)
+        return ret;
+    sec &= ~RTC_STAT_BIT_OSF;
+    ret = tr->write(tr->ctx, RTC_SEC_REG_ADDR, &sec, 1);
+    if (ret < 0)
+        return ret;
+
+    // Set control register: Enable Battery-Backed Square-Wave Output
+    val = RTC_CTL_BIT_INTCN | RTC_CTL_BIT_RS1 | RTC_CTL_BIT_RS2;
+    return tr->write(tr->ctx, RTC_CTL_REG_ADDR, &val, 1);
+}
+
+int ds3231_get_time(const struct ds3231_transport *tr, struct ds3231_time *tm)
+{
+    unsigned char regs[7];
+    int ret;
+
+    ret = tr->read(tr->ctx, RTC_SEC_REG_ADDR, regs, sizeof(regs));
+    if (ret < 0)
+        return ret;
+    ds3231_decode_time(regs, tm);
+    return ret;
+}
+
+// Time and date in one transaction, so the chip never holds half of an update
+int ds3231_set_time(const struct ds3231_transport *tr, const struct ds3231_time *tm)
+{
+    unsigned char regs[7];
+
+    if (tm->sec > 59 || tm->min > 59 || tm->hour > 23 || tm->day < 1 || tm->day > 7 ||
+        tm->date < 1 || tm->date > 31 || tm->month < 1 || tm->month > 12 || tm->year > 99)
+        return -EINVAL;
+
+    ds3231_encode_time(tm, regs);
+    return tr->write(tr->ctx, RTC_SEC_REG_ADDR, regs, sizeof(regs));
+}
+
+// Control, status and temperature are adjacent, one read covers them
+int ds3231_get_status(const struct ds3231_transport *tr, struct ds3231_status *st)
+{
+    unsigned char regs[RTC_NR_REGS - RTC_CTL_REG_ADDR];
+    int ret;
+
+    ret = tr->read(tr->ctx, RTC_CTL_REG_ADDR, regs, sizeof(regs));
+    if (ret < 0)
+        return ret;
+    st->ctl = regs[0];
+    st->status = regs[RTC_STAT_REG_ADDR - RTC_CTL_REG_ADDR];
+    st->temp_qc = ds3231_decode_temp(&regs[RTC_TEMP_MSB_REG_ADDR - RTC_CTL_REG_ADDR]);
+    return ret;
+}
+
+int ds3231_get_alarm1(const struct ds3231_transport *tr, unsigned char alarm[4])
+{
+    return tr->read(tr->ctx, RTC_ALM1_REG_ADDR, alarm, 4);
+}
+
+// Program the alarm 1 registers, enable its interrupt and clear a pending flag
+int ds3231_set_alarm1(const struct ds3231_transport *tr, const unsigned char alarm[4])
+{
+    unsigned char regs[2], ctl, status;
+    int ret;
+
+    ret = tr->read(tr->ctx, RTC_CTL_REG_ADDR, regs, sizeof(regs));
+    if (ret < 0)
+        return ret;
+    ctl = regs[0];
+    status = regs[1];
+
+    // Set the alarm time
+    ret = tr->write(tr->ctx, RTC_ALM1_REG_ADDR, alarm, 4);
+    if (ret < 0)
+        return ret;
+
+    // Enable Alarm 1 interrupt. INTCN is left alone: without it the pin carries the square
+    // wave and A1F has to be polled.
+    if (!(ctl & RTC_CTL_BIT_A1IE)) {
+        ctl |= RTC_CTL_BIT_A1IE;
+        ret = tr->write(tr->ctx, RTC_CTL_REG_ADDR, &ctl, 1);
+        if (ret < 0)
+            return ret;
+    }
+
+    // Clear the A1F bit in the status register if it is set
+    if (status & RTC_STAT_BIT_A1F) {
+        status &= ~RTC_STAT_BIT_A1F;
+        ret = tr->write(tr->ctx, RTC_STAT_REG_ADDR, &status, 1);
+        if (ret < 0)
+            return ret;
+    }
+    return 0;
+}
+
+static int arm_alarm1_abs(const struct ds3231_transport *tr, int64_t now, int64_t target)
+{
+    unsigned char alarm[4];
+    int step, ret;
+
+    step = ds3231_plan_alarm1_abs(now, target, alarm);
+    if (step < 0)
+        return step;
+    ret = ds3231_set_alarm1(tr, alarm);
+    return ret < 0 ? ret : step;
+}
+
+// Arm alarm 1 for an absolute RTC time, returns 1 if an intermediate alarm was armed and the
+// caller has to arm again when it fires, see ds3231_plan_alarm1_abs
+int ds3231_arm_alarm1_abs(const struct ds3231_transport *tr, int64_t target)
+{
+    unsigned char regs[7];
+    int ret;
+
+    ret = tr->read(tr->ctx, RTC_SEC_REG_ADDR, regs, sizeof(regs));
+    if (ret < 0)
+        return ret;
+    return arm_alarm1_abs(tr, ds3231_regs_to_time(regs), target);
+}
+
+// One-shot alarm after a delay. Offsets of a day or more go through the absolute alarm, the
+// time match alone would wrap at 24 hours, and *target is set to the absolute time then, 0
+// otherwise. Returns like ds3231_arm_alarm1_abs.
+int ds3231_set_alarm1_after(const struct ds3231_transport *tr, unsigned int hour, unsigned int min,
+                            unsigned int sec, int64_t *target)
+{
+    int64_t offset = (int64_t)hour * 3600 + (int64_t)min * 60 + sec;
+    unsigned char regs[7], alarm[4];
+    struct ds3231_time tm;
+    int64_t now;
+    int ret;
+
+    *target = 0;
+    ret = tr->read(tr->ctx, RTC_SEC_REG_ADDR, regs, sizeof(regs));
+    if (ret < 0)
+        return ret;
+    now = ds3231_regs_to_time(regs);
+
+    if (offset >= 24 * 3600) {
+        ret = arm_alarm1_abs(tr, now, now + offset);
+        if (ret >= 0)
+            *target = now + offset;
+        return ret;
+    }
+
+    ds3231_time_to_tm(now + offset, &tm);
+    ds3231_encode_alarm1(DS3231_ALM_MATCH_HMS, 0, tm.hour, tm.min, tm.sec, alarm);
+    return ds3231_set_alarm1(tr, alarm);
+}
+
+// Output the square wave at rate Hz on INT/SQW, or the alarm interrupts again for rate 0
+int ds3231_set_sqw(const struct ds3231_transport *tr, unsigned int rate)
+{
+    unsigned char ctl, val;
+    int ret;
+
+    switch (rate) {
+    case 0:
+        val = RTC_CTL_BIT_INTCN;
+        break;
+    case 1:
+        val = 0;
+        break;
+    case 1024:
+        val = RTC_CTL_BIT_RS1;
+        break;
+    case 4096:
+        val = RTC_CTL_BIT_RS2;
+        break;
+    case 8192:
+        val = RTC_CTL_BIT_RS1 | RTC_CTL_BIT_RS2;
+        break;
+    default:
+        return -EINVAL;
+    }
+
+    ret = tr->read(tr->ctx, RTC_CTL_REG_ADDR, &ctl, 1);
+    if (ret < 0)
+        return ret;
+    // The rate bits are kept while the alarm interrupts are on the pin
+    if (rate)
+        val |= ctl & ~(RTC_CTL_BIT_INTCN | RTC_CTL_BIT_RS1 | RTC_CTL_BIT_RS2);
+    else
+        val |= ctl;
+    if (val == ctl)
+        return 0;
+    return tr->write(tr->ctx, RTC_CTL_REG_ADDR, &val, 1);
+}
+
+// Control and status for the alarm interrupt, and the time if need_time. Behind a cache that
+// announced both ranges this is one bulk read.
+int ds3231_get_alarm1_irq(const struct ds3231_transport *tr, bool need_time, struct ds3231_alarm1_irq *irq)
+{
+    unsigned char regs[7];
+    int ret;
+
+    irq->rtc_sec = 0;
+    if (need_time) {
+        ret = tr->read(tr->ctx, RTC_SEC_REG_ADDR, regs, sizeof(regs));
+        if (ret < 0)
+            return ret;
+        irq->rtc_sec = ds3231_regs_to_time(regs);
+    }
+    ret = tr->read(tr->ctx, RTC_CTL_REG_ADDR, regs, 2);
+    if (ret < 0)
+        return ret;
+    irq->ctl = regs[0];
+    irq->status = regs[1];
+    return 0;
+}
+
+// Clear the A1F found by ds3231_get_alarm1_irq. disable also turns the alarm 1 interrupt off,
+// in the same write, for a one-shot alarm.
+int ds3231_ack_alarm1(const struct ds3231_transport *tr, const struct ds3231_alarm1_irq *irq, bool disable)
+{
+    unsigned char regs[2] = { irq->ctl & ~RTC_CTL_BIT_A1IE, irq->status & ~RTC_STAT_BIT_A1F };
+
+    if (!(irq->status & RTC_STAT_BIT_A1F))
+        return 0;
+    if (disable)
+        return tr->write(tr->ctx, RTC_CTL_REG_ADDR, regs, 2);
+    return tr->write(tr->ctx, RTC_STAT_REG_ADDR, &regs[1], 1);
+}
+
+// Write the control register as a whole, e.g. to put back one saved before the chip lost its
+// supplies
+int ds3231_set_ctl(const struct ds3231_transport *tr, unsigned char ctl)
+{
+    return tr->write(tr->ctx, RTC_CTL_REG_ADDR, &ctl, 1);
+}
+
+/* register sequences end */
+
+/* register cache start */
+
+static int cache_fetch(struct ds3231_cache *c, unsigned int mask)
+{
+    unsigned int want, reg, first, last;
+    int ret;
+
+    for (reg = 0; reg < RTC_NR_REGS; reg++) {
+        if ((mask & (1U << reg)) && c->id[reg] <= c->cur.ticket)
+            break;
+    }
+    if (reg == RTC_NR_REGS) {
+        c->coalesced++;
+        return 0;
+    }
+
+    want = mask | c->cur.announced;
+    if (c->take_pending)
+        want |= c->take_pending(c);
+    for (first = 0; !(want & (1U << first)); first++)
+        ;
+    for (last = RTC_NR_REGS - 1; !(want & (1U << last)); last--)
+        ;
+
+    ret = c->bus->read(c->bus->ctx, first, &c->regs[first], last - first + 1);
+    if (ret < 0)
+        return ret;
+    c->cur.xfers += 2;
+    c->cur.bytes += 1 + last - first + 1;
+
+    c->cur.announced = 0;
+    c->reads_started++;
+    c->bulk_reads++;
+    for (reg = first; reg <= last; reg++)
+        c->id[reg] = c->reads_started;
+    return 0;
+}
+
+static int cache_read(void *ctx, unsigned int reg, unsigned char *buf, unsigned int len)
+{
+    struct ds3231_cache *c = ctx;
+    int ret;
+
+    if (reg + len > RTC_NR_REGS)
+        return -EINVAL;
+    ret = cache_fetch(c, RTC_REGS_MASK(reg, len));
+    if (ret < 0)
+        return ret;
+    memcpy(buf, &c->regs[reg], len);
+    return 0;
+}
+
+// Like cache_read, but if the bus fails the last values read are served and DS3231_STALE is
+// returned. Fails only when nothing usable is cached.
+static int cache_read_stale(void *ctx, unsigned int reg, unsigned char *buf, unsigned int len)
+{
+    struct ds3231_cache *c = ctx;
+    unsigned int mask = RTC_REGS_MASK(reg, len), i;
+    int ret;
+
+    if (reg + len > RTC_NR_REGS)
+        return -EINVAL;
+    if ((c->cur.stale & mask) != mask) {
+        ret = cache_fetch(c, mask);
+        if (ret >= 0) {
+            memcpy(buf, &c->regs[reg], len);
+            return 0;
+        }
+        if (!c->serve_stale)
+            return ret;
+        for (i = reg; i < reg + len; i++) {
+            if (!c->id[i])
+                return ret;
+        }
+        c->cur.stale |= mask;
+        c->stale_served++;
+    }
+    memcpy(buf, &c->regs[reg], len);
+    return DS3231_STALE;
+}
+
+static int cache_write(void *ctx, unsigned int reg, const unsigned char *buf, unsigned int len)
+{
+    struct ds3231_cache *c = ctx;
+    unsigned int i;
+    int ret;
+
+    if (reg + len > RTC_NR_REGS)
+        return -EINVAL;
+    for (i = reg; i < reg + len; i++)
+        c->id[i] = 0;
+    ret = c->bus->write(c->bus->ctx, reg, buf, len);
+    if (ret < 0)
+        return ret;
+    c->cur.xfers++;
+    c->cur.bytes += 1 + len;
+    return 0;
+}
+
+// Empty cache in front of bus, take_pending and serve_stale are left to the caller
+void ds3231_cache_init(struct ds3231_cache *c, const struct ds3231_transport *bus)
+{
+    memset(c, 0, sizeof(*c));
+    c->bus = bus;
+    c->tr.read = cache_read;
+    c->tr.write = cache_write;
+    c->tr.ctx = c;
+    c->tr_stale.read = cache_read_stale;
+    c->tr_stale.write = cache_write;
+    c->tr_stale.ctx = c;
+}
+
+// Start operation op. ticket is reads_started as seen when the operation arrived, before it
+// waited for its turn: bulk reads issued since then are recent enough to share.
+void ds3231_cache_begin(struct ds3231_cache *c, enum ds3231_op op, unsigned long ticket)
+{
+    c->cur.op = op;
+    c->cur.ticket = ticket;
+    c->cur.announced = ds3231_budgets[op].read_regs;
+    c->cur.stale = 0;
+    c->cur.xfers = 0;
+    c->cur.bytes = 0;
+}
+
+/* register cache end */
@@ -0,0 +1,216 @@
+// DS3231 register map, register encoding and register sequences. Built into the kernel module
+// and into the userspace library in app/, so nothing here may depend on either side: register
+// access goes through a struct ds3231_transport supplied by the caller.
+#ifndef DS3231_CORE_H
+#define DS3231_CORE_H
+
+#ifdef __KERNEL__
+#include <linux/types.h>
+#else
+#include <stdint.h>
+#include <stdbool.h>
+#endif
+
+#define RTC_SEC_REG_ADDR    (0x00)
+#define RTC_MIN_REG_ADDR    (0x01)
+#define RTC_HR_REG_ADDR     (0x02)
+#define RTC_DAY_REG_ADDR    (0x03)
+#define RTC_DATE_REG_ADDR   (0x04)
+#define RTC_MON_REG_ADDR    (0x05)
+#define RTC_YR_REG_ADDR     (0x06)
+#define RTC_ALM1_REG_ADDR   (0x07)
+#define RTC_ALM2_REG_ADDR   (0x0B)
+#define RTC_CTL_REG_ADDR    (0x0E)
+#define RTC_STAT_REG_ADDR   (0x0F)
+#define RTC_AGING_REG_ADDR  (0x10)
+#define RTC_TEMP_MSB_REG_ADDR (0x11)
+#define RTC_TEMP_LSB_REG_ADDR (0x12)
+#define RTC_NR_REGS         (0x13)   // Registers 0x00 (seconds) to 0x12 (temperature LSB)
+
+#define RTC_A1M1            (0x80)
+#define RTC_A1M2            (0x80)
+#define RTC_A1M4            (0x80)
+#define RTC_A1M3            (0x80)
+#define RTC_A1_DYDT         (0x40)   // In the alarm 1 day/date register: match the day of week
+
+// Alarm 1 rates, from the A1M1-A1M4 mask bits and DY/DT
+enum ds3231_alarm_mode {
+    DS3231_ALM_EVERY_SECOND,    // Once per second
+    DS3231_ALM_MATCH_SEC,       // When seconds match
+    DS3231_ALM_MATCH_MIN_SEC,   // When minutes and seconds match
+    DS3231_ALM_MATCH_HMS,       // When hours, minutes and seconds match
+    DS3231_ALM_MATCH_DATE,      // When date, hours, minutes and seconds match
+    DS3231_ALM_MATCH_DAY,       // When day of week, hours, minutes and seconds match
+    DS3231_ALM_MODE_MAX
+};
+
+#define RTC_CTL_BIT_A1IE    (0x01)
+#define RTC_CTL_BIT_A2IE    (0x02)
+#define RTC_CTL_BIT_INTCN   (0x04)
+#define RTC_CTL_BIT_RS1     (0x08)
+#define RTC_CTL_BIT_RS2     (0x10)
+#define RTC_CTL_BIT_DOSC    (0x80)
+
+#define RTC_STAT_BIT_A1F    (0x01)
+#define RTC_STAT_BIT_A2F    (0x02)
+#define RTC_STAT_BIT_OSF    (0x80)
+
+// Time and date in binary, 24 hour mode
+struct ds3231_time {
+    unsigned int sec, min, hour;
+    unsigned int day;           // Day of the week, 1 (Sunday) to 7
+    unsigned int date;          // Day of the month, 1 to 31
+    unsigned int month;         // 1 to 12
+    unsigned int year;          // Years since 2000
+};
+
+// Control and status registers and the die temperature in 0.25 C steps
+struct ds3231_status {
+    unsigned char ctl, status;
+    int temp_qc;
+};
+
+// Register access. Both return 0 or a negative errno. read may return a positive value
+// instead of 0 to flag the data, e.g. as cached, read-only sequences pass it back.
+struct ds3231_transport {
+    int (*read)(void *ctx, unsigned int reg, unsigned char *buf, unsigned int len);
+    int (*write)(void *ctx, unsigned int reg, const unsigned char *buf, unsigned int len);
+    void *ctx;
+};
+
+// Returned by reads of ds3231_cache.tr_stale that served cached values because the bus failed
+#define DS3231_STALE        (1)
+
+// What the alarm interrupt found, see ds3231_get_alarm1_irq
+struct ds3231_alarm1_irq {
+    unsigned char ctl, status;
+    int64_t rtc_sec;            // RTC time, 0 if it was not read
+};
+
+static inline unsigned char ds3231_bcd2bin(unsigned char val)
+{
+    return ((val >> 4) * 10) + (val & 0x0F);
+}
+
+static inline unsigned char ds3231_bin2bcd(unsigned char bin)
+{
+    return ((bin / 10) << 4) + (bin % 10);
+}
+
+// Register masks used to request ranges from the coalesced read path
+#define RTC_REGS_MASK(first, count) (((1U << (count)) - 1) << (first))
+#define RTC_TIME_REGS       RTC_REGS_MASK(RTC_SEC_REG_ADDR, 7)
+#define RTC_ALM1_REGS       RTC_REGS_MASK(RTC_ALM1_REG_ADDR, 4)
+#define RTC_STAT_REGS       RTC_REGS_MASK(RTC_STAT_REG_ADDR, 1)
+#define RTC_CTL_STAT_REGS   RTC_REGS_MASK(RTC_CTL_REG_ADDR, 2)
+#define RTC_TEMP_REGS       RTC_REGS_MASK(RTC_TEMP_MSB_REG_ADDR, 2)
+
+// User-facing operations of the driver, each one runs with the bus lock held
+enum ds3231_op {
+    DS3231_OP_INIT,
+    DS3231_OP_IOCTL_RD_TIME,
+    DS3231_OP_IOCTL_WR_TIME,
+    DS3231_OP_IOCTL_RD_ALARM1,
+    DS3231_OP_IOCTL_WR_ALARM1,
+    DS3231_OP_IOCTL_RD_ALM1_MODE,
+    DS3231_OP_IOCTL_WR_ALM1_MODE,
+    DS3231_OP_IOCTL_RD_ALM1_ABS,
+    DS3231_OP_IOCTL_WR_ALM1_ABS,
+    DS3231_OP_IOCTL_RD_STATUS,
+    DS3231_OP_SYSFS_RTC_SHOW,
+    DS3231_OP_SYSFS_RTC_STORE,
+    DS3231_OP_SYSFS_ALARM_SHOW,
+    DS3231_OP_SYSFS_ALARM_STORE,
+    DS3231_OP_SYSFS_ALARM_MODE_SHOW,
+    DS3231_OP_SYSFS_ALARM_MODE_STORE,
+    DS3231_OP_SYSFS_ALARM_AT_SHOW,
+    DS3231_OP_SYSFS_ALARM_AT_STORE,
+    DS3231_OP_PROC_READ,
+    DS3231_OP_ALARM_IRQ,
+    DS3231_OP_ALARM_REARM,
+    DS3231_OP_DRIFT_SAMPLE,
+    DS3231_OP_PM_SUSPEND,
+    DS3231_OP_PM_RESUME,
+    DS3231_OP_HIRES_RATE,
+    DS3231_OP_MAX
+};
+
+// Maximum I2C transactions and bytes on the wire (register address included) per operation.
+// read_regs are the registers the operation reads, announced before it waits for the bus so
+// that a caller already holding it can fetch them in the same bulk read. A bulk read may span
+// the whole register file, so read budgets allow for 1 + RTC_NR_REGS bytes.
+struct ds3231_op_budget {
+    const char *name;
+    unsigned int max_xfers;
+    unsigned int max_bytes;
+    unsigned int read_regs;
+};
+
+extern const struct ds3231_op_budget ds3231_budgets[DS3231_OP_MAX];
+
+// Register cache in front of a transport, for a caller that runs operations one at a time.
+// Reads are served from bulk reads of the register file: a read whose registers were all
+// filled by a bulk read issued after the operation started is coalesced, otherwise one bulk
+// read covers it, the registers the operation announced in its budget and whatever
+// take_pending returns for operations waiting their turn. Writes go straight through and
+// drop the written registers from the cache. The transactions and bytes of the accesses that
+// succeeded are counted per operation, a read being a register pointer write and a read.
+struct ds3231_cache {
+    const struct ds3231_transport *bus;
+    unsigned int (*take_pending)(struct ds3231_cache *c);  // May be NULL
+    bool serve_stale;           // Reads of tr_stale fall back to the cache when the bus fails
+
+    unsigned char regs[RTC_NR_REGS];
+    unsigned long id[RTC_NR_REGS];  // Bulk read that last filled each register, 0 once written
+    unsigned long reads_started;
+
+    // Current operation, reset by ds3231_cache_begin
+    struct ds3231_cache_op {
+        enum ds3231_op op;
+        unsigned long ticket;   // Bulk reads after this one are shared
+        unsigned int announced; // Budget registers not read yet
+        unsigned int stale;     // Registers already served stale
+        unsigned int xfers, bytes;
+    } cur;
+
+    unsigned long bulk_reads, coalesced, stale_served;
+
+    // Transports for the register sequences, tr_stale for read-only paths
+    struct ds3231_transport tr, tr_stale;
+};
+
+void ds3231_cache_init(struct ds3231_cache *c, const struct ds3231_transport *bus);
+void ds3231_cache_begin(struct ds3231_cache *c, enum ds3231_op op, unsigned long ticket);
+
+extern const unsigned char ds3231_alarm_masks[DS3231_ALM_MODE_MAX][4];
+extern const char * const ds3231_alarm_mode_names[DS3231_ALM_MODE_MAX];
+
+// Encoding, no register access
+int64_t ds3231_mktime(const struct ds3231_time *tm);
+void ds3231_time_to_tm(int64_t t, struct ds3231_time *tm);
+void ds3231_decode_time(const unsigned char regs[7], struct ds3231_time *tm);
+int64_t ds3231_regs_to_time(const unsigned char regs[7]);
+void ds3231_encode_time(const struct ds3231_time *tm, unsigned char regs[7]);
+int ds3231_decode_temp(const unsigned char regs[2]);
+int ds3231_encode_alarm1(unsigned int mode, unsigned int day, unsigned int hour, unsigned int min,
+                         unsigned int sec, unsigned char alarm[4]);
+int ds3231_decode_alarm1(const unsigned char alarm[4], unsigned int *day, unsigned int *hour,
+                         unsigned int *min, unsigned int *sec);
+int ds3231_plan_alarm1_abs(int64_t now, int64_t target, unsigned char alarm[4]);
+
+// Register sequences
+int ds3231_init_chip(const struct ds3231_transport *tr);
+int ds3231_get_time(const struct ds3231_transport *tr, struct ds3231_time *tm);
+int ds3231_set_time(const struct ds3231_transport *tr, const struct ds3231_time *tm);
+int ds3231_get_status(const struct ds3231_transport *tr, struct ds3231_status *st);
+int ds3231_get_alarm1(const struct ds3231_transport *tr, unsigned char alarm[4]);
+int ds3231_set_alarm1(const struct ds3231_transport *tr, const unsigned char alarm[4]);
+int ds3231_arm_alarm1_abs(const struct ds3231_transport *tr, int64_t target);
+int ds3231_set_alarm1_after(const struct ds3231_transport *tr, unsigned int hour, unsigned int min,
+                            unsigned int sec, int64_t *target);
+int ds3231_set_sqw(const struct ds3231_transport *tr, unsigned int rate);
+int ds3231_get_alarm1_irq(const struct ds3231_transport *tr, bool need_time, struct ds3231_alarm1_irq *irq);
+int ds3231_ack_alarm1(const struct ds3231_transport *tr, const struct ds3231_alarm1_irq *irq, bool disable);
+int ds3231_set_ctl(const struct ds3231_transport *tr, unsigned char ctl);
+
+#endif
@@ -0,0 +1,2654 @@
+#include <linux/module.h>
+#include <linux/init.h>
+#include <linux/kdev_t.h>
+#include <linux/fs.h>
+#include <linux/cdev.h>
+#include <linux/device.h>
+#include <linux/uaccess.h>
+#include <linux/slab.h>
+#include <linux/i2c.h>
+#include <linux/delay.h>
+#include <linux/kernel.h>
+#include <linux/time.h>
+#include <linux/kthread.h>
+#include <linux/sched.h>
+#include <linux/io.h>
+#include <linux/gpio.h>     
+#include <linux/interrupt.h>
+#include <linux/err.h>
+#include <linux/proc_fs.h>
+#include <linux/mutex.h>
+#include <linux/moduleparam.h>
+#include <linux/vmalloc.h>
+#include <linux/mm.h>
+#include <linux/pm.h>
+#include <linux/pm_wakeup.h>
+#include <linux/poll.h>
+#include <linux/wait.h>
+#include <linux/spinlock.h>
+#include <linux/eventfd.h>
+#include <linux/list.h>
+#include <net/genetlink.h>
+
+#include "ds3231_core.h"
+
+#define CLASS_NAME "rtc_class"
+
+#define I2C_BUS_AVAILABLE   (2)   // I2C Bus available in our Beaglebone black
+#define SLAVE_DEVICE_NAME   ("DS3231")   // Device and Driver Name
+#define DS3231_SLAVE_ADDR   (0x68)   // DS3231 RTC Slave Address
+
+#define DS3231_ALARM_GPIO_PIN (20) // GPIO pin number connected to DS3231 SQW pin
+
+// Where INT/SQW comes in, e.g. a gpio-sim line to drive the alarm path from userspace
+static int alarm_gpio = DS3231_ALARM_GPIO_PIN;
+module_param(alarm_gpio, int, 0444);
+MODULE_PARM_DESC(alarm_gpio, "GPIO connected to the DS3231 INT/SQW pin (default 20)");
+
+static int alarm_irq = -1;
+module_param(alarm_irq, int, 0444);
+MODULE_PARM_DESC(alarm_irq, "IRQ to use instead of the one of alarm_gpio, which is then left alone (default -1)");
+
+int GPIO_irqNumber;
+static struct kobject *kobj_ref;
+
+static struct workqueue_struct *ds3231_wq;
+static struct work_struct ds3231_work;
+
+static void ds3231_work_handler(struct work_struct *work);
+
+// Set from suspend until resume, the I2C controller may be down in between
+static bool ds3231_suspended;
+
+// Protected by ds3231_bus_lock. alarm1_repeat is false for one-shot alarms, which are
+// disabled once they fire, and true for the recurring modes the chip repeats by itself.
+static bool alarm1_status = false;
+static bool alarm1_repeat = false;
+// RTC time of a pending absolute alarm, 0 if none. Alarm 1 may hold an intermediate alarm on
+// the way to it.
+static time64_t alarm1_target;
+
+static struct i2c_adapter *rtc_i2c_adapter = NULL;
+static struct i2c_client *rtc_i2c_client = NULL;
+
+// Function prototypes
+static int DS3231_SetTime(const struct ds3231_time *tm);
+static void ds3231_hr_anchor(time64_t sec, u64 boot_ns);
+
+// Declare system time function
+static void get_system_time(struct ds3231_time *tm);
+
+static int DS3231_SetAlarm1After(unsigned int hour_add, unsigned int min_add, unsigned int sec_add);
+
+/* I2C accounting start */
+
+struct ds3231_op_stats {
+    unsigned long calls, xfers, bytes;
+    unsigned int max_xfers, max_bytes;
+    unsigned long violations;
+};
+
+// Serializes every register access, a register read is a write/read pair on the bus
+static DEFINE_MUTEX(ds3231_bus_lock);
+
+// All below are protected by ds3231_bus_lock
+static struct ds3231_op_stats ds3231_stats[DS3231_OP_MAX];
+
+// Register cache in front of DS3231_Xfer, see struct ds3231_cache. Every register access of
+// an operation goes through ds3231_cache.tr, or ds3231_cache.tr_stale on read-only paths.
+static struct ds3231_cache ds3231_cache;
+
+// Registers wanted by callers waiting for the bus, merged into the next bulk read
+static atomic_t ds3231_pending_regs = ATOMIC_INIT(0);
+
+static unsigned int DS3231_TakePending(struct ds3231_cache *c)
+{
+    return atomic_xchg(&ds3231_pending_regs, 0);
+}
+
+static bool serve_stale = true;
+module_param(serve_stale, bool, 0644);
+MODULE_PARM_DESC(serve_stale, "Serve the last values read, flagged as stale, when the bus fails (default Y)");
+
+// Start an operation: take the bus and reset the transaction counters
+static void DS3231_OpBegin(enum ds3231_op op)
+{
+    // Any bulk read completed after this point can be shared with this operation
+    unsigned long ticket = READ_ONCE(ds3231_cache.reads_started);
+
+    atomic_or(ds3231_budgets[op].read_regs, &ds3231_pending_regs);
+    mutex_lock(&ds3231_bus_lock);
+    ds3231_cache.serve_stale = READ_ONCE(serve_stale);
+    ds3231_cache_begin(&ds3231_cache, op, ticket);
+}
+
+// Finish an operation: check it against its budget and release the bus
+static void DS3231_OpEnd(void)
+{
+    const struct ds3231_cache *c = &ds3231_cache;
+    const struct ds3231_op_budget *budget = &ds3231_budgets[c->cur.op];
+    struct ds3231_op_stats *st = &ds3231_stats[c->cur.op];
+
+    st->calls++;
+    st->xfers += c->cur.xfers;
+    st->bytes += c->cur.bytes;
+    st->max_xfers = max(st->max_xfers, c->cur.xfers);
+    st->max_bytes = max(st->max_bytes, c->cur.bytes);
+
+    if (c->cur.xfers > budget->max_xfers || c->cur.bytes > budget->max_bytes) {
+        st->violations++;
+        pr_warn_ratelimited("DS3231: %s used %u transactions / %u bytes, budget is %u / %u\n",
+                            budget->name, c->cur.xfers, c->cur.bytes,
+                            budget->max_xfers, budget->max_bytes);
+    }
+    mutex_unlock(&ds3231_bus_lock);
+}
+
+/* I2C accounting end */
+
+/* Bus fault handling start */
+
+// A failed register access is retried up to retry_max times with exponential backoff. The
+// bus lock is dropped during the backoff, and accesses by other operations fail fast until the
+// retry is done, so read-only paths serve stale values instead of queueing behind the sleep.
+// After breaker_threshold consecutive failed accesses the breaker opens and accesses fail fast
+// for breaker_cooldown_ms, after which one access is let through to probe the bus again.
+static unsigned int retry_max = 2;
+module_param(retry_max, uint, 0644);
+MODULE_PARM_DESC(retry_max, "Retries of a failed I2C register access (default 2)");
+
+static unsigned int retry_backoff_us = 200;
+module_param(retry_backoff_us, uint, 0644);
+MODULE_PARM_DESC(retry_backoff_us, "Delay before the first retry in microseconds, doubled on each retry (default 200)");
+
+static unsigned int breaker_threshold = 5;
+module_param(breaker_threshold, uint, 0644);
+MODULE_PARM_DESC(breaker_threshold, "Consecutive failed accesses that open the circuit breaker, 0 to disable (default 5)");
+
+static unsigned int breaker_cooldown_ms = 1000;
+module_param(breaker_cooldown_ms, uint, 0644);
+MODULE_PARM_DESC(breaker_cooldown_ms, "Time the circuit breaker stays open before probing the bus again (default 1000)");
+
+// Upper bound for the doubled retry delay
+#define DS3231_MAX_BACKOFF_US (20000)
+
+// All below are protected by ds3231_bus_lock
+static unsigned int ds3231_consecutive_failures;
+static bool ds3231_breaker_open;
+static unsigned long ds3231_breaker_opened;
+static unsigned long ds3231_retries, ds3231_failures, ds3231_fast_fails;
+static bool ds3231_retrying;
+
+static int I2C_Write(unsigned char *buf, unsigned int len)
+{
+    lockdep_assert_held(&ds3231_bus_lock);
+    return i2c_master_send(rtc_i2c_client, buf, len);
+}
+
+static int I2C_Read(unsigned char *out_buf, unsigned int len)
+{
+    lockdep_assert_held(&ds3231_bus_lock);
+    return i2c_master_recv(rtc_i2c_client, out_buf, len);
+}
+
+// One register access: write the register pointer followed by data, or the pointer then read
+static int DS3231_XferOnce(bool read, unsigned char reg_addr, unsigned char *data, unsigned int len)
+{
+    unsigned char buf[RTC_NR_REGS + 1];
+    int ret;
+
+    if (read) {
+        ret = I2C_Write(&reg_addr, 1);
+        if (ret != 1) {
+            pr_err("I2C write error: %d\n", ret);
+            return ret < 0 ? ret : -EIO;
+        }
+        ret = I2C_Read(data, len);
+    } else {
+        buf[0] = reg_addr;
+        memcpy(&buf[1], data, len);
+        len++;
+        ret = I2C_Write(buf, len);
+    }
+
+    if (ret != len) {
+        pr_err("I2C %s error: %d\n", read ? "read" : "write", ret);
+        return ret < 0 ? ret : -EIO;
+    }
+    return 0;
+}
+
+// Sleep before a retry without holding the bus. Operations that take the bus meanwhile fail
+// their accesses, they neither touch the chip nor count as failures. Their cache_begin
+// overwrote the operation state, which is put back for the one retrying.
+static void DS3231_Backoff(unsigned int us)
+{
+    struct ds3231_cache_op cur = ds3231_cache.cur;
+
+    ds3231_retrying = true;
+    mutex_unlock(&ds3231_bus_lock);
+    usleep_range(us, us * 2);
+    mutex_lock(&ds3231_bus_lock);
+    ds3231_retrying = false;
+    ds3231_cache.cur = cur;
+}
+
+// Register access with bounded retries, fails fast while the circuit breaker is open or
+// another operation is retrying. May drop the bus lock, see DS3231_Backoff.
+static int DS3231_Xfer(bool read, unsigned char reg_addr, unsigned char *data, unsigned int len)
+{
+    unsigned int backoff = retry_backoff_us;
+    unsigned int attempt;
+    int ret;
+
+    lockdep_assert_held(&ds3231_bus_lock);
+
+    if (ds3231_retrying ||
+        (ds3231_breaker_open &&
+         time_before(jiffies, ds3231_breaker_opened + msecs_to_jiffies(breaker_cooldown_ms)))) {
+        ds3231_fast_fails++;
+        return -EIO;
+    }
+
+    // Only the access that succeeds is counted against the operation budget, by the cache
+    for (attempt = 0; ; attempt++) {
+        ret = DS3231_XferOnce(read, reg_addr, data, len);
+        if (!ret)
+            break;
+        if (attempt >= retry_max)
+            break;
+
+        ds3231_retries++;
+        if (backoff)
+            DS3231_Backoff(backoff);
+        backoff = min(backoff * 2, (unsigned int)DS3231_MAX_BACKOFF_US);
+    }
+
+    if (!ret) {
+        if (ds3231_breaker_open)
+            pr_info("DS3231: bus recovered, circuit breaker closed\n");
+        ds3231_breaker_open = false;
+        ds3231_consecutive_failures = 0;
+        return 0;
+    }
+
+    ds3231_failures++;
+    if (breaker_threshold && ++ds3231_consecutive_failures >= breaker_threshold) {
+        if (!ds3231_breaker_open)
+            pr_warn("DS3231: %u consecutive bus failures, circuit breaker open\n",
+                    ds3231_consecutive_failures);
+        ds3231_breaker_open = true;
+        ds3231_breaker_opened = jiffies;
+    }
+    return ret;
+}
+
+/* Bus fault handling end */
+
+/* core transport start */
+
+// The bus below ds3231_cache, bus lock held
+static int DS3231_BusRead(void *ctx, unsigned int reg, unsigned char *buf, unsigned int len)
+{
+    return DS3231_Xfer(true, reg, buf, len);
+}
+
+static int DS3231_BusWrite(void *ctx, unsigned int reg, const unsigned char *buf, unsigned int len)
+{
+    unsigned char data[RTC_NR_REGS];
+
+    memcpy(data, buf, len);
+    return DS3231_Xfer(false, reg, data, len);
+}
+
+static const struct ds3231_transport ds3231_bus = {
+    .read = DS3231_BusRead,
+    .write = DS3231_BusWrite,
+};
+
+/* core transport end */
+
+//Function to print data
+static void DS3231_PrintTimeDate(void)
+{
+    struct ds3231_time tm;
+
+    if (ds3231_get_time(&ds3231_cache.tr_stale, &tm) < 0) {
+        pr_err("Failed to read time and date\n");
+        return;
+    }
+
+    pr_info("Current Time: %02u:%02u:%02u\n", tm.hour, tm.min, tm.sec);
+    pr_info("Current Date: %02u/%02u/20%02u (Day of week: %02u)\n", tm.date, tm.month, tm.year, tm.day);
+}
+
+//Initialization of ds3231
+static int DS3231_Init(void)
+{
+    // Get system time and date
+    struct ds3231_time tm;
+    int ret;
+
+    pr_info("DS3231_Init - Initializes the DS3231 RTC with default settings");
+
+    ret = ds3231_init_chip(&ds3231_cache.tr);
+    if (ret < 0)
+        return ret;
+
+    // Set DS3231 time and date to match the system time and date
+    get_system_time(&tm);
+    ret = DS3231_SetTime(&tm);
+    if (ret < 0) {
+        pr_err("Failed to set time\n");
+        return ret; 
+    }
+
+    return ret;
+}
+
+// Function to set the time and date, in one transaction
+static int DS3231_SetTime(const struct ds3231_time *tm)
+{
+    // Writing the seconds restarts the chip's divider chain, and so the second
+    u64 start = ktime_get_boot_ns();
+    int ret;
+
+    pr_info(" DS3231_SetTime - Sets the time on the DS3231 RTC");
+    ret = ds3231_set_time(&ds3231_cache.tr, tm);
+    if (ret >= 0)
+        ds3231_hr_anchor(ds3231_mktime(tm), start);
+    return ret;
+}
+
+// Function to set the alarm on the DS3231 RTC
+// Program the alarm 1 registers, enable its interrupt and clear a pending flag
+static int DS3231_SetAlarm1Regs(const unsigned char alarm[4], bool repeat)
+{
+    int ret;
+
+    ret = ds3231_set_alarm1(&ds3231_cache.tr, alarm);
+    if (ret < 0)
+        return ret;
+
+    // indicate the status of alarm
+    alarm1_status = true;
+    alarm1_repeat = repeat;
+    return 0;
+}
+
+// Set a recurring alarm, arguments in binary, see ds3231_encode_alarm1
+static int DS3231_SetAlarm1Mode(unsigned int mode, unsigned int day, unsigned int hour,
+                                unsigned int min, unsigned int sec)
+{
+    unsigned char alarm[4];
+    int ret;
+
+    ret = ds3231_encode_alarm1(mode, day, hour, min, sec, alarm);
+    if (ret < 0)
+        return ret;
+
+    ret = DS3231_SetAlarm1Regs(alarm, true);
+    if (ret < 0)
+        return ret;
+    alarm1_target = 0;
+
+    pr_info("Alarm 1 set to %s, day %u, %02u:%02u:%02u\n", ds3231_alarm_mode_names[mode], day, hour, min, sec);
+    return 0;
+}
+
+// Arm alarm 1 for an absolute RTC time in seconds since the epoch. A target beyond the current
+// month gets an intermediate alarm, where the work handler re-arms it, so a distant alarm
+// costs one reprogram per month.
+static int DS3231_ArmAlarm1Abs(time64_t target)
+{
+    int ret;
+
+    ret = ds3231_arm_alarm1_abs(&ds3231_cache.tr, target);
+    if (ret < 0)
+        return ret;
+    alarm1_status = true;
+    alarm1_repeat = false;
+    alarm1_target = target;
+
+    pr_info("Alarm 1 armed for %lld%s\n", (long long)target, ret ? ", intermediate alarm set" : "");
+    return 0;
+}
+
+// Function to set the alarm on the DS3231 RTC after a specified duration
+static int DS3231_SetAlarm1After(unsigned int hour_add, unsigned int min_add, unsigned int sec_add)
+{
+    s64 target;
+    int ret;
+
+    pr_info("DS3231_SetAlarm1After - Sets Alarm 1 on the DS3231 RTC after %u hours, %u minutes, %u seconds\n", hour_add, min_add, sec_add);
+
+    ret = ds3231_set_alarm1_after(&ds3231_cache.tr, hour_add, min_add, sec_add, &target);
+    if (ret < 0)
+        return ret;
+    alarm1_status = true;
+    alarm1_repeat = false;
+    alarm1_target = target;
+    return 0;
+}
+
+// Function to get system time and date
+static void get_system_time(struct ds3231_time *tm)
+{
+    ds3231_time_to_tm(ktime_get_real_seconds(), tm);
+}
+
+static int ds3231_probe(struct i2c_client *client, const struct i2c_device_id *id)
+{
+    int ret;
+
+    rtc_i2c_client = client;
+
+    // The alarm can wake the system, userspace may turn this off through power/wakeup
+    device_init_wakeup(&client->dev, true);
+
+    DS3231_OpBegin(DS3231_OP_INIT);
+    ret = DS3231_Init();
+    if (ret < 0) {
+        pr_err("DS3231: initialization failed: %d\n", ret);
+        DS3231_OpEnd();
+        return ret;
+    }
+    DS3231_PrintTimeDate();
+    DS3231_OpEnd();
+
+    // Set alarm for given seconds from now
+    //DS3231_SetAlarm1After(0, 0, 10);
+
+    return 0;
+}
+
+
+static int ds3231_remove(struct i2c_client *client)
+{
+    if (!rtc_i2c_client) {
+        pr_info("DS3231: Already removed!\n");
+        return 0;
+    }
+
+    device_init_wakeup(&client->dev, false);
+    return 0;
+}
+
+static const struct i2c_device_id ds3231_id[] = {
+    { SLAVE_DEVICE_NAME, 0 },
+    { }
+};
+MODULE_DEVICE_TABLE(i2c, ds3231_id);
+
+static int __maybe_unused ds3231_suspend(struct device *dev);
+static int __maybe_unused ds3231_resume(struct device *dev);
+static SIMPLE_DEV_PM_OPS(ds3231_pm_ops, ds3231_suspend, ds3231_resume);
+
+static struct i2c_driver ds3231_driver = {
+    .driver = {
+        .name   = SLAVE_DEVICE_NAME,
+        .owner  = THIS_MODULE,
+        .pm     = &ds3231_pm_ops,
+    },
+    .probe          = ds3231_probe,
+    .remove         = ds3231_remove,
+    .id_table       = ds3231_id,
+};
+
+static struct i2c_board_info rtc_i2c_board_info = {
+
+    I2C_BOARD_INFO(SLAVE_DEVICE_NAME, DS3231_SLAVE_ADDR)
+};
+
+/* netlink events start */
+
+// RTC events are broadcast on the "events" multicast group of the "DS3231" generic netlink
+// family. Each event is one message built once and handed to the netlink core, so the driver
+// keeps no per-listener state. Events are also queued for blocking read() and poll() on
+// /dev/DS3231, see the event queue below. Nothing is done while nobody listens on either.
+#define DS3231_GENL_NAME        "DS3231"
+#define DS3231_GENL_VERSION     (1)
+#define DS3231_GENL_MCGRP_NAME  "events"
+
+enum ds3231_genl_cmd {
+    DS3231_CMD_UNSPEC,
+    DS3231_CMD_EVENT,
+};
+
+enum ds3231_genl_attr {
+    DS3231_ATTR_UNSPEC,
+    DS3231_ATTR_TYPE,           // u32, enum ds3231_event
+    DS3231_ATTR_SEQ,            // u32, event number
+    DS3231_ATTR_REALTIME_NS,    // s64, CLOCK_REALTIME when the event was seen
+    DS3231_ATTR_MONOTONIC_NS,   // s64, CLOCK_MONOTONIC when the event was seen
+    DS3231_ATTR_RTC_SEC,        // s64, RTC time in seconds since the epoch
+    DS3231_ATTR_STATUS,         // u8, status register
+    DS3231_ATTR_PAD,
+    __DS3231_ATTR_MAX,
+};
+#define DS3231_ATTR_MAX (__DS3231_ATTR_MAX - 1)
+
+enum ds3231_event {
+    DS3231_EVENT_ALARM1 = 1,    // Alarm 1 matched
+    DS3231_EVENT_OSF,           // Oscillator stop flag found set, the time is not valid
+    DS3231_EVENT_TIME_SET,      // Time and date were written
+};
+
+static const struct genl_multicast_group ds3231_genl_mcgrps[] = {
+    { .name = DS3231_GENL_MCGRP_NAME },
+};
+
+static struct genl_family ds3231_genl_family = {
+    .name       = DS3231_GENL_NAME,
+    .version    = DS3231_GENL_VERSION,
+    .maxattr    = DS3231_ATTR_MAX,
+    .module     = THIS_MODULE,
+    .mcgrps     = ds3231_genl_mcgrps,
+    .n_mcgrps   = ARRAY_SIZE(ds3231_genl_mcgrps),
+};
+
+static bool ds3231_genl_registered;
+
+// Protected by ds3231_bus_lock, OSF is reported once until it is seen clear again
+static bool ds3231_osf_reported;
+
+// Event record returned by read() on /dev/DS3231, same fields as the netlink attributes
+struct ds3231_event_rec {
+    __u32 type;
+    __u32 seq;
+    __s64 rtc_sec;
+    __s64 realtime_ns;
+    __s64 monotonic_ns;
+    __u8 status;
+    __u8 pad[7];
+};
+
+// The last DS3231_EVQ_LEN events. Each open file keeps its position in f_pos as the number of
+// events queued before the next one it reads, starting at the time of open(). A reader that
+// falls more than DS3231_EVQ_LEN behind skips to the oldest event kept, the gap shows in seq.
+#define DS3231_EVQ_LEN (64)
+
+static struct ds3231_event_rec ds3231_evq[DS3231_EVQ_LEN];
+static u32 ds3231_evq_head;     // Events queued so far, protected by ds3231_evq_lock
+static DEFINE_SPINLOCK(ds3231_evq_lock);
+static DECLARE_WAIT_QUEUE_HEAD(ds3231_evq_wait);
+static atomic_t ds3231_evq_readers = ATOMIC_INIT(0);   // Files in ds3231_evq_listen()
+
+static bool ds3231_event_listeners(void)
+{
+    return atomic_read(&ds3231_evq_readers) ||
+           (ds3231_genl_registered && genl_has_listeners(&ds3231_genl_family, &init_net, 0));
+}
+
+static bool ds3231_evq_pending(loff_t pos)
+{
+    return READ_ONCE(ds3231_evq_head) != (u32)pos;
+}
+
+// SIGIO owners of /dev/DS3231 and eventfds registered with REG_ALM1_EVENTFD. Signalling them
+// walks every registration, so it runs from its own work item: ds3231_notify_event only counts
+// what happened and queues ds3231_fanout_work, which stays O(1) however many there are.
+struct ds3231_efd {
+    struct list_head node;
+    struct eventfd_ctx *ctx;
+};
+
+// Per open file of /dev/DS3231, in file->private_data
+struct ds3231_file {
+    struct ds3231_efd *efd;     // Protected by ds3231_efd_lock
+    unsigned long listening;    // Bit 0 set once counted in ds3231_evq_readers
+};
+
+// The file waits for events: read(), poll(), O_ASYNC or an eventfd. Files that are only
+// opened for ioctls do not count, or every open would make the driver queue events.
+static void ds3231_evq_listen(struct file *file)
+{
+    struct ds3231_file *df = file->private_data;
+
+    if (!test_and_set_bit(0, &df->listening))
+        atomic_inc(&ds3231_evq_readers);
+}
+
+static struct fasync_struct *ds3231_fasync;
+static LIST_HEAD(ds3231_efd_list);          // Protected by ds3231_efd_lock
+static DEFINE_MUTEX(ds3231_efd_lock);
+static atomic_t ds3231_fanout_events = ATOMIC_INIT(0);
+static atomic_t ds3231_fanout_alarms = ATOMIC_INIT(0);
+
+static void ds3231_fanout_handler(struct work_struct *work)
+{
+    struct ds3231_efd *efd;
+    int alarms = atomic_xchg(&ds3231_fanout_alarms, 0);
+
+    // Events queued meanwhile are covered by one signal, like a second read() would be
+    if (atomic_xchg(&ds3231_fanout_events, 0))
+        kill_fasync(&ds3231_fasync, SIGIO, POLL_IN);
+
+    if (!alarms)
+        return;
+    // The eventfd counter goes up by the number of alarms, none is lost when runs merge
+    mutex_lock(&ds3231_efd_lock);
+    list_for_each_entry(efd, &ds3231_efd_list, node)
+        eventfd_signal(efd->ctx, alarms);
+    mutex_unlock(&ds3231_efd_lock);
+}
+
+static DECLARE_WORK(ds3231_fanout_work, ds3231_fanout_handler);
+
+static void ds3231_fanout(enum ds3231_event type)
+{
+    atomic_inc(&ds3231_fanout_events);
+    if (type == DS3231_EVENT_ALARM1)
+        atomic_inc(&ds3231_fanout_alarms);
+    schedule_work(&ds3231_fanout_work);
+}
+
+// Broadcast one event, called from process context without the bus lock held
+static void ds3231_notify_event(enum ds3231_event type, time64_t rtc_sec, unsigned char status)
+{
+    struct ds3231_event_rec rec = {
+        .type = type,
+        .rtc_sec = rtc_sec,
+        .realtime_ns = ktime_get_real_ns(),
+        .monotonic_ns = ktime_get_ns(),
+        .status = status,
+    };
+    struct sk_buff *skb;
+    void *hdr;
+
+    if (!ds3231_event_listeners())
+        return;
+
+    // The sequence number is taken under the queue lock so that queue order and seq agree
+    spin_lock(&ds3231_evq_lock);
+    rec.seq = ds3231_evq_head + 1;
+    ds3231_evq[ds3231_evq_head & (DS3231_EVQ_LEN - 1)] = rec;
+    WRITE_ONCE(ds3231_evq_head, ds3231_evq_head + 1);
+    spin_unlock(&ds3231_evq_lock);
+    wake_up_interruptible(&ds3231_evq_wait);
+    ds3231_fanout(type);
+
+    if (!ds3231_genl_registered || !genl_has_listeners(&ds3231_genl_family, &init_net, 0))
+        return;
+
+    skb = genlmsg_new(nla_total_size(sizeof(u32)) * 2 + nla_total_size_64bit(sizeof(s64)) * 3 +
+                      nla_total_size(sizeof(u8)), GFP_KERNEL);
+    if (!skb)
+        return;
+
+    hdr = genlmsg_put(skb, 0, 0, &ds3231_genl_family, 0, DS3231_CMD_EVENT);
+    if (!hdr)
+        goto err;
+
+    if (nla_put_u32(skb, DS3231_ATTR_TYPE, rec.type) ||
+        nla_put_u32(skb, DS3231_ATTR_SEQ, rec.seq) ||
+        nla_put_s64(skb, DS3231_ATTR_REALTIME_NS, rec.realtime_ns, DS3231_ATTR_PAD) ||
+        nla_put_s64(skb, DS3231_ATTR_MONOTONIC_NS, rec.monotonic_ns, DS3231_ATTR_PAD) ||
+        nla_put_s64(skb, DS3231_ATTR_RTC_SEC, rec.rtc_sec, DS3231_ATTR_PAD) ||
+        nla_put_u8(skb, DS3231_ATTR_STATUS, rec.status)) {
+        genlmsg_cancel(skb, hdr);
+        goto err;
+    }
+    genlmsg_end(skb, hdr);
+
+    // Fails with -ESRCH when the last listener left meanwhile, nothing to do then
+    genlmsg_multicast(&ds3231_genl_family, skb, 0, 0, GFP_KERNEL);
+    return;
+err:
+    nlmsg_free(skb);
+}
+
+// Check a freshly read status register for a new oscillator stop, bus lock held
+static bool DS3231_OsfRaised(unsigned char status)
+{
+    lockdep_assert_held(&ds3231_bus_lock);
+
+    if (!(status & RTC_STAT_BIT_OSF)) {
+        ds3231_osf_reported = false;
+        return false;
+    }
+    if (ds3231_osf_reported)
+        return false;
+    ds3231_osf_reported = true;
+    return true;
+}
+
+// Time set from sysfs or ioctl
+static void ds3231_notify_time_set(const struct ds3231_time *tm)
+{
+    if (ds3231_event_listeners())
+        ds3231_notify_event(DS3231_EVENT_TIME_SET, ds3231_mktime(tm), 0);
+}
+
+/* netlink events end */
+
+/* sub-second timebase start */
+
+// With hires_rate set, INTCN is cleared and INT/SQW carries the square wave instead of the alarm
+// interrupts. Every falling edge is counted in the interrupt handler, so the time is known to
+// 1/rate of a second without touching the bus: the RTC second of the last rollover plus the
+// edges since. The divider chain restarts when the seconds are written, which anchors the
+// count. An edge that comes more than 1.5 periods after the previous one stands for the edges
+// missed in between. Once per second the alarm work reads the time registers, polls A1F and
+// resyncs the second if the count went wrong. Timestamps are taken on the boottime clock, so
+// edges missed while suspended are accounted for on the first edge after resume.
+static unsigned int hires_rate;
+module_param(hires_rate, uint, 0444);
+MODULE_PARM_DESC(hires_rate, "Count the square wave at 1024, 4096 or 8192 Hz for sub-second time, alarms are then polled once per second (default 0, off)");
+
+struct ds3231_hr {
+    unsigned int rate;          // Square wave being counted, 0 when off
+    time64_t sec;               // RTC time at the last rollover
+    unsigned int edges;         // Edges since the last rollover
+    u64 last_ns;                // Boottime of the last edge, or of the anchor
+    // Statistics since the rate was set or reset
+    u64 since_ns;
+    u64 irqs, missed, irq_ns, max_irq_ns;
+    unsigned long resyncs;
+};
+
+static struct ds3231_hr ds3231_hr;
+static DEFINE_SEQLOCK(ds3231_hr_lock);
+
+// Time and date were just written, the next rollover is one second after start
+static void ds3231_hr_anchor(time64_t sec, u64 boot_ns)
+{
+    unsigned long flags;
+
+    write_seqlock_irqsave(&ds3231_hr_lock, flags);
+    ds3231_hr.sec = sec;
+    ds3231_hr.edges = 0;
+    ds3231_hr.last_ns = boot_ns;
+    write_sequnlock_irqrestore(&ds3231_hr_lock, flags);
+}
+
+// Falling edge of the square wave, in hard interrupt context. The rate is read again under
+// the lock: hr_stop may have cleared it since the handler looked, and the edge is then the
+// alarm interrupt the pin is going back to.
+static void ds3231_hr_edge(void)
+{
+    u64 start = ktime_get_boot_ns();
+    u64 gap, n = 1, period;
+    unsigned int rate;
+    bool rollover = false;
+
+    write_seqlock(&ds3231_hr_lock);
+    rate = ds3231_hr.rate;
+    if (!rate) {
+        write_sequnlock(&ds3231_hr_lock);
+        queue_work(ds3231_wq, &ds3231_work);
+        return;
+    }
+    period = div_u64(NSEC_PER_SEC, rate);
+    gap = start - ds3231_hr.last_ns;
+    if (gap > period + period / 2) {
+        n = div64_u64(gap + period / 2, period);
+        ds3231_hr.missed += n - 1;
+    }
+    ds3231_hr.last_ns = start;
+    n += ds3231_hr.edges;
+    if (n >= rate) {
+        ds3231_hr.sec += div_u64_rem(n, rate, &ds3231_hr.edges);
+        rollover = true;
+    } else {
+        ds3231_hr.edges = n;
+    }
+    ds3231_hr.irqs++;
+    gap = ktime_get_boot_ns() - start;
+    ds3231_hr.irq_ns += gap;
+    ds3231_hr.max_irq_ns = max(ds3231_hr.max_irq_ns, gap);
+    write_sequnlock(&ds3231_hr_lock);
+
+    // Poll the alarm flag and check the count against the chip once per second
+    if (rollover)
+        queue_work(ds3231_wq, &ds3231_work);
+}
+
+// Time read from the chip by the alarm work. It only says which second it is, so it is
+// trusted early in a counted second, where a late work item cannot have crossed a rollover.
+static void ds3231_hr_check(time64_t rtc_sec)
+{
+    unsigned long flags;
+
+    write_seqlock_irqsave(&ds3231_hr_lock, flags);
+    if (ds3231_hr.rate && ds3231_hr.edges < ds3231_hr.rate / 2 && ds3231_hr.sec != rtc_sec) {
+        ds3231_hr.sec = rtc_sec;
+        ds3231_hr.resyncs++;
+    }
+    write_sequnlock_irqrestore(&ds3231_hr_lock, flags);
+}
+
+// Current RTC time to the nanosecond, interpolated from the last edge, without bus traffic
+static int ds3231_hr_read(time64_t *sec, u32 *nsec, unsigned int *rate)
+{
+    unsigned int seq, edges;
+    u64 last_ns, now, period, frac;
+
+    do {
+        seq = read_seqbegin(&ds3231_hr_lock);
+        now = ktime_get_boot_ns();
+        *rate = ds3231_hr.rate;
+        *sec = ds3231_hr.sec;
+        edges = ds3231_hr.edges;
+        last_ns = ds3231_hr.last_ns;
+    } while (read_seqretry(&ds3231_hr_lock, seq));
+
+    if (!*rate)
+        return -EOPNOTSUPP;
+
+    // Never past the next edge, however late its interrupt is
+    period = div_u64(NSEC_PER_SEC, *rate);
+    frac = div_u64((u64)edges * NSEC_PER_SEC, *rate) + min(now - last_ns, period - 1);
+    *nsec = min_t(u64, frac, NSEC_PER_SEC - 1);
+    return 0;
+}
+
+// Start counting at rate or switch to it, bus lock held. The chip keeps the square wave in
+// phase with the second across rates, so the edge count is scaled over.
+static int ds3231_hr_set_rate(unsigned int rate)
+{
+    unsigned long flags;
+    int ret;
+
+    if (rate != 1024 && rate != 4096 && rate != 8192)
+        return -EINVAL;
+
+    ret = ds3231_set_sqw(&ds3231_cache.tr, rate);
+    if (ret < 0)
+        return ret;
+
+    write_seqlock_irqsave(&ds3231_hr_lock, flags);
+    if (ds3231_hr.rate)
+        ds3231_hr.edges = div_u64((u64)ds3231_hr.edges * rate, ds3231_hr.rate);
+    ds3231_hr.rate = rate;
+    ds3231_hr.since_ns = ktime_get_boot_ns();
+    ds3231_hr.irqs = 0;
+    ds3231_hr.missed = 0;
+    ds3231_hr.irq_ns = 0;
+    ds3231_hr.max_irq_ns = 0;
+    ds3231_hr.resyncs = 0;
+    write_sequnlock_irqrestore(&ds3231_hr_lock, flags);
+    WRITE_ONCE(hires_rate, rate);
+    return 0;
+}
+
+// Back to alarm interrupts on the pin, on unload
+static void ds3231_hr_stop(void)
+{
+    unsigned long flags;
+
+    if (!READ_ONCE(ds3231_hr.rate))
+        return;
+
+    write_seqlock_irqsave(&ds3231_hr_lock, flags);
+    ds3231_hr.rate = 0;
+    write_sequnlock_irqrestore(&ds3231_hr_lock, flags);
+
+    DS3231_OpBegin(DS3231_OP_HIRES_RATE);
+    if (ds3231_set_sqw(&ds3231_cache.tr, 0) < 0)
+        pr_err("DS3231: cannot switch INT/SQW back to the alarm interrupt\n");
+    DS3231_OpEnd();
+}
+
+/* sub-second timebase end */
+
+/* IRQ latency start */
+
+// Latency of the alarm path in log2 buckets of nanoseconds: from the interrupt to the start of
+// the work, and from there to the alarm event being queued. The interrupt keeps the time of the
+// oldest edge not handled yet. Edges that come before the work picks it up are coalesced.
+#define DS3231_LAT_BUCKETS  (40)
+
+struct ds3231_lat_stage {
+    unsigned long count;
+    u64 sum_ns, min_ns, max_ns;
+    unsigned long hist[DS3231_LAT_BUCKETS];
+};
+
+// All below are protected by ds3231_lat_lock
+static struct {
+    u64 irq_ns;                 // Oldest edge not picked up by the work, 0 if none
+    unsigned long irqs, coalesced, works, alarms;
+    struct ds3231_lat_stage irq_work, work_event;
+} ds3231_lat;
+static DEFINE_SPINLOCK(ds3231_lat_lock);
+
+static void ds3231_lat_add(struct ds3231_lat_stage *st, u64 ns)
+{
+    if (!st->count || ns < st->min_ns)
+        st->min_ns = ns;
+    st->max_ns = max(st->max_ns, ns);
+    st->sum_ns += ns;
+    st->count++;
+    st->hist[min_t(unsigned int, ns ? fls64(ns) - 1 : 0, DS3231_LAT_BUCKETS - 1)]++;
+}
+
+// Alarm edge, in hard interrupt context
+static void ds3231_lat_irq(void)
+{
+    u64 now = ktime_get_ns();
+
+    spin_lock(&ds3231_lat_lock);
+    ds3231_lat.irqs++;
+    if (ds3231_lat.irq_ns)
+        ds3231_lat.coalesced++;
+    else
+        ds3231_lat.irq_ns = now;
+    spin_unlock(&ds3231_lat_lock);
+}
+
+// Alarm work starting, returns its start time
+static u64 ds3231_lat_work(void)
+{
+    u64 now = ktime_get_ns();
+
+    spin_lock_irq(&ds3231_lat_lock);
+    ds3231_lat.works++;
+    if (ds3231_lat.irq_ns) {
+        ds3231_lat_add(&ds3231_lat.irq_work, now - ds3231_lat.irq_ns);
+        ds3231_lat.irq_ns = 0;
+    }
+    spin_unlock_irq(&ds3231_lat_lock);
+    return now;
+}
+
+// Alarm event about to be queued by the work started at start
+static void ds3231_lat_event(u64 start)
+{
+    u64 now = ktime_get_ns();
+
+    spin_lock_irq(&ds3231_lat_lock);
+    ds3231_lat.alarms++;
+    ds3231_lat_add(&ds3231_lat.work_event, now - start);
+    spin_unlock_irq(&ds3231_lat_lock);
+}
+
+/* IRQ latency end */
+
+// Interrupt handler
+static irqreturn_t ds3231_irq_handler(int irq, void *dev_id)
+{
+    // Alarm during suspend: report the wakeup and let resume handle it once the bus is back
+    if (READ_ONCE(ds3231_suspended)) {
+        pm_wakeup_event(&rtc_i2c_client->dev, 0);
+        return IRQ_HANDLED;
+    }
+
+    // Square wave edge in high resolution mode, the alarm is polled
+    if (READ_ONCE(ds3231_hr.rate)) {
+        ds3231_hr_edge();
+        return IRQ_HANDLED;
+    }
+
+    // Schedule the work to be handled in process context
+    ds3231_lat_irq();
+    queue_work(ds3231_wq, &ds3231_work);
+    return IRQ_HANDLED;
+}
+
+// Re-arm a pending absolute alarm after an intermediate alarm fired or the time was set
+static void ds3231_alarm_rearm(void)
+{
+    int ret;
+
+    if (!READ_ONCE(alarm1_target))
+        return;
+
+    DS3231_OpBegin(DS3231_OP_ALARM_REARM);
+    if (alarm1_target) {
+        ret = DS3231_ArmAlarm1Abs(alarm1_target);
+        if (ret == -EINVAL) {
+            // The time was set past the target
+            pr_warn("DS3231: absolute alarm at %lld was skipped by a time change\n", (long long)alarm1_target);
+            alarm1_target = 0;
+        } else if (ret < 0) {
+            pr_err_ratelimited("DS3231: cannot re-arm the absolute alarm: %d\n", ret);
+        }
+    }
+    DS3231_OpEnd();
+}
+
+static void ds3231_work_handler(struct work_struct *work) {
+   
+        struct ds3231_alarm1_irq irq;
+        unsigned char status;
+        bool alarm, osf, rearm = false;
+        time64_t rtc_sec;
+        u64 start = ds3231_lat_work();
+        bool hires = READ_ONCE(ds3231_hr.rate);
+        bool need_time = ds3231_event_listeners() || hires;
+
+        DS3231_OpBegin(DS3231_OP_ALARM_IRQ);
+         // Read control and status, and the time for event listeners, absolute alarms and the
+         // edge count check in the same bulk read
+    	if (alarm1_target)
+    		need_time = true;
+    	if (ds3231_get_alarm1_irq(&ds3231_cache.tr, need_time, &irq) < 0) {
+    		pr_err_ratelimited("DS3231: cannot read status register on alarm interrupt\n");
+    		DS3231_OpEnd();
+    		return;
+    	}
+    	status = irq.status;
+    	rtc_sec = irq.rtc_sec;
+    	if (hires)
+    		ds3231_hr_check(rtc_sec);
+    	osf = DS3231_OsfRaised(status);
+ 
+    	// Check if the alarm flag is set
+    	alarm = status & RTC_STAT_BIT_A1F;
+    	if (alarm && alarm1_target && rtc_sec < alarm1_target) {
+    		// Intermediate alarm on the way to an absolute one, keep it armed and move it on
+    		if (ds3231_ack_alarm1(&ds3231_cache.tr, &irq, false) < 0)
+    			pr_err_ratelimited("DS3231: cannot clear the alarm 1 flag\n");
+    		alarm = false;
+    		rearm = true;
+    	} else if (alarm) {
+    		alarm1_target = 0;
+		// Handle the alarm event here
+    		//pr_info("Alarm Ringing, Status register: 0x%02x\n", status);
+    		pr_info("Alarm 1 is Ringing :)\n");
+ 
+        	// The chip repeats a recurring alarm, only clear the flag. A one-shot alarm also
+        	// gets its interrupt disabled, in the same write.
+        	if (ds3231_ack_alarm1(&ds3231_cache.tr, &irq, !alarm1_repeat) < 0)
+        		pr_err_ratelimited("DS3231: cannot clear the alarm 1 flag\n");
+        	// indicate the status of alarm
+        	if (!alarm1_repeat)
+        		alarm1_status = false;
+        }
+        DS3231_OpEnd();
+
+        if (rearm)
+        	ds3231_alarm_rearm();
+
+        // Broadcast after releasing the bus
+        if (alarm) {
+        	ds3231_lat_event(start);
+        	ds3231_notify_event(DS3231_EVENT_ALARM1, rtc_sec, status);
+        }
+        if (osf)
+        	ds3231_notify_event(DS3231_EVENT_OSF, rtc_sec, status);
+}
+
+/* drift telemetry start */
+
+// Ring buffer of (RTC time, realtime, monotonic, temperature) samples, mapped by userspace
+// through mmap() on /dev/DS3231. The header page is followed by nr_entries samples, both mapped
+// read-only. The reader's tail lives alone in the page at tail_offset, the only one it may map
+// writable. The driver only advances head and the reader only advances tail. When the ring is
+// full, new samples are dropped and counted until the reader catches up.
+#define DS3231_DRIFT_MAGIC      (0x44524654)   // "DRFT"
+#define DS3231_DRIFT_VERSION    (2)
+
+#define DS3231_DRIFT_FLAG_OSF   (0x0001)   // Oscillator stop flag was set when sampled
+
+struct ds3231_drift_sample {
+    __s64 rtc_sec;          // RTC time in seconds since the epoch
+    __s64 realtime_ns;      // CLOCK_REALTIME right after the RTC read
+    __s64 monotonic_ns;     // CLOCK_MONOTONIC right after the RTC read
+    __s16 temp_qc;          // Die temperature in 0.25 C steps
+    __u16 flags;
+    __u32 seq;              // Sample number, wraps at 2^32
+};
+
+struct ds3231_drift_ring {
+    __u32 magic;
+    __u32 version;
+    __u32 nr_entries;       // Power of two
+    __u32 entry_size;
+    __u32 data_offset;      // Offset of the first sample from the start of the mapping
+    __u32 interval_ms;
+    __u64 head;             // Samples written, advanced by the driver
+    __u64 tail_offset;      // mmap() offset of the page holding the reader's __u64 tail
+    __u64 dropped;          // Samples lost because the ring was full
+};
+
+static unsigned int drift_entries = 4096;
+module_param(drift_entries, uint, 0444);
+MODULE_PARM_DESC(drift_entries, "Drift samples kept in the ring buffer, rounded up to a power of two, 0 to disable (default 4096)");
+
+static unsigned int drift_interval_ms;
+static struct ds3231_drift_ring *ds3231_drift_ring;
+static size_t ds3231_drift_size;
+static struct delayed_work ds3231_drift_work;
+
+// The header page is only a copy for the reader, the sampler works from these
+static struct ds3231_drift_sample *ds3231_drift_data;
+static unsigned int ds3231_drift_nr;
+static u64 ds3231_drift_head, ds3231_drift_dropped;
+static u64 *ds3231_drift_tail;
+
+// Orders restarts of the sampler against teardown, nothing restarts it once stopping is set
+static DEFINE_MUTEX(ds3231_drift_lock);
+static bool ds3231_drift_stopping;
+
+static void ds3231_drift_kick(void)
+{
+    mutex_lock(&ds3231_drift_lock);
+    if (!ds3231_drift_stopping && ds3231_wq && ds3231_drift_ring)
+        mod_delayed_work(ds3231_wq, &ds3231_drift_work, 0);
+    mutex_unlock(&ds3231_drift_lock);
+}
+
+// Restart the sampler when the interval is changed at runtime
+static int drift_interval_set(const char *val, const struct kernel_param *kp)
+{
+    int ret = param_set_uint(val, kp);
+
+    if (!ret)
+        ds3231_drift_kick();
+    return ret;
+}
+
+static const struct kernel_param_ops drift_interval_ops = {
+    .set = drift_interval_set,
+    .get = param_get_uint,
+};
+module_param_cb(drift_interval_ms, &drift_interval_ops, &drift_interval_ms, 0644);
+MODULE_PARM_DESC(drift_interval_ms, "Interval between RTC drift samples in milliseconds, 0 to stop (default 0)");
+
+static void ds3231_drift_handler(struct work_struct *work)
+{
+    struct ds3231_drift_ring *ring = READ_ONCE(ds3231_drift_ring);
+    struct ds3231_drift_sample *sample;
+    unsigned int interval = READ_ONCE(drift_interval_ms);
+    s64 realtime_ns, monotonic_ns;
+    struct ds3231_status st;
+    struct ds3231_time tm;
+    unsigned char status;
+    time64_t rtc_sec;
+    bool osf;
+    u64 head;
+    int ret;
+
+    if (!interval || !ring)
+        return;
+
+    // One bulk read serves both, the operation announced time, status and temperature
+    DS3231_OpBegin(DS3231_OP_DRIFT_SAMPLE);
+    ret = ds3231_get_time(&ds3231_cache.tr, &tm);
+    if (ret >= 0)
+        ret = ds3231_get_status(&ds3231_cache.tr, &st);
+    realtime_ns = ktime_get_real_ns();
+    monotonic_ns = ktime_get_ns();
+    if (ret < 0) {
+        DS3231_OpEnd();
+        goto out;
+    }
+    rtc_sec = ds3231_mktime(&tm);
+    status = st.status;
+    osf = DS3231_OsfRaised(status);
+
+    // A tail ahead of head or more than a ring behind is bogus, and reads as a full ring
+    head = ds3231_drift_head;
+    if (head - smp_load_acquire(ds3231_drift_tail) >= ds3231_drift_nr) {
+        ring->dropped = ++ds3231_drift_dropped;
+        DS3231_OpEnd();
+        goto notify;
+    }
+
+    sample = &ds3231_drift_data[head & (ds3231_drift_nr - 1)];
+    sample->rtc_sec = rtc_sec;
+    sample->realtime_ns = realtime_ns;
+    sample->monotonic_ns = monotonic_ns;
+    sample->temp_qc = st.temp_qc;
+    sample->flags = (status & RTC_STAT_BIT_OSF) ? DS3231_DRIFT_FLAG_OSF : 0;
+    sample->seq = (u32)head;
+    DS3231_OpEnd();
+
+    // Publish the sample before the new head
+    ds3231_drift_head = head + 1;
+    smp_store_release(&ring->head, ds3231_drift_head);
+
+notify:
+    if (osf)
+        ds3231_notify_event(DS3231_EVENT_OSF, rtc_sec, status);
+out:
+    ring->interval_ms = interval;
+    if (!READ_ONCE(ds3231_drift_stopping))
+        queue_delayed_work(ds3231_wq, &ds3231_drift_work, msecs_to_jiffies(interval));
+}
+
+// Allocate the ring buffer and the tail page, userspace maps them so they come from vmalloc_user()
+static int ds3231_drift_init(void)
+{
+    unsigned int nr;
+
+    INIT_DELAYED_WORK(&ds3231_drift_work, ds3231_drift_handler);
+    if (!drift_entries)
+        return 0;
+
+    nr = roundup_pow_of_two(drift_entries);
+    ds3231_drift_size = PAGE_ALIGN(PAGE_SIZE + (size_t)nr * sizeof(struct ds3231_drift_sample));
+    ds3231_drift_tail = vmalloc_user(PAGE_SIZE);
+    if (!ds3231_drift_tail)
+        return -ENOMEM;
+    ds3231_drift_ring = vmalloc_user(ds3231_drift_size);
+    if (!ds3231_drift_ring) {
+        vfree(ds3231_drift_tail);
+        ds3231_drift_tail = NULL;
+        return -ENOMEM;
+    }
+    ds3231_drift_data = (struct ds3231_drift_sample *)((char *)ds3231_drift_ring + PAGE_SIZE);
+    ds3231_drift_nr = nr;
+    ds3231_drift_head = 0;
+    ds3231_drift_dropped = 0;
+
+    ds3231_drift_ring->magic = DS3231_DRIFT_MAGIC;
+    ds3231_drift_ring->version = DS3231_DRIFT_VERSION;
+    ds3231_drift_ring->nr_entries = nr;
+    ds3231_drift_ring->entry_size = sizeof(struct ds3231_drift_sample);
+    ds3231_drift_ring->data_offset = PAGE_SIZE;
+    ds3231_drift_ring->interval_ms = drift_interval_ms;
+    ds3231_drift_ring->tail_offset = ds3231_drift_size;
+
+    if (drift_interval_ms)
+        queue_delayed_work(ds3231_wq, &ds3231_drift_work, 0);
+    return 0;
+}
+
+static void ds3231_drift_exit(void)
+{
+    struct ds3231_drift_ring *ring;
+
+    // A parameter write from now on finds the sampler stopped and the ring gone
+    mutex_lock(&ds3231_drift_lock);
+    ds3231_drift_stopping = true;
+    ring = ds3231_drift_ring;
+    WRITE_ONCE(ds3231_drift_ring, NULL);
+    mutex_unlock(&ds3231_drift_lock);
+
+    cancel_delayed_work_sync(&ds3231_drift_work);
+    vfree(ring);
+    vfree(ds3231_drift_tail);
+    ds3231_drift_tail = NULL;
+}
+
+/* drift telemetry end */
+
+/* power management start */
+
+// Alarm 1 is a wakeup source. Suspend saves the control register and arms the IRQ for
+// wakeup, resume restores the control register if the chip lost it and handles an alarm
+// that fired while the system was asleep, since its interrupt may never reach the handler.
+
+// All below are protected by ds3231_bus_lock
+static unsigned char ds3231_saved_ctl;
+static bool ds3231_irq_wake;
+static ktime_t ds3231_suspended_at;
+static unsigned long ds3231_suspends, ds3231_resumes, ds3231_wake_alarms, ds3231_ctl_restored;
+static s64 ds3231_suspend_us, ds3231_max_suspend_us, ds3231_resume_us, ds3231_max_resume_us;
+static s64 ds3231_sleep_ms;
+
+static int __maybe_unused ds3231_suspend(struct device *dev)
+{
+    ktime_t start = ktime_get();
+    struct ds3231_status st;
+    int ret;
+
+    // Stop background bus users before the controller goes down
+    if (ds3231_drift_ring)
+        cancel_delayed_work_sync(&ds3231_drift_work);
+    if (ds3231_wq)
+        flush_work(&ds3231_work);
+
+    DS3231_OpBegin(DS3231_OP_PM_SUSPEND);
+    ret = ds3231_get_status(&ds3231_cache.tr, &st);
+    if (ret < 0) {
+        DS3231_OpEnd();
+        pr_err("DS3231: cannot save the control register on suspend: %d\n", ret);
+        return ret;
+    }
+    ds3231_saved_ctl = st.ctl;
+
+    // The square wave would wake the system at once, put the alarm back on the pin
+    if (READ_ONCE(ds3231_hr.rate) && ds3231_set_sqw(&ds3231_cache.tr, 0) < 0)
+        pr_err("DS3231: cannot switch INT/SQW to the alarm interrupt on suspend\n");
+
+    WRITE_ONCE(ds3231_suspended, true);
+    ds3231_irq_wake = device_may_wakeup(dev) && !enable_irq_wake(GPIO_irqNumber);
+
+    ds3231_suspends++;
+    ds3231_suspend_us = ktime_us_delta(ktime_get(), start);
+    ds3231_max_suspend_us = max(ds3231_max_suspend_us, ds3231_suspend_us);
+    ds3231_suspended_at = ktime_get_boottime();
+    DS3231_OpEnd();
+
+    return 0;
+}
+
+static int __maybe_unused ds3231_resume(struct device *dev)
+{
+    ktime_t start = ktime_get();
+    bool alarm = false, osf = false;
+    struct ds3231_status st;
+    int ret;
+
+    DS3231_OpBegin(DS3231_OP_PM_RESUME);
+    if (ds3231_irq_wake)
+        disable_irq_wake(GPIO_irqNumber);
+    ds3231_irq_wake = false;
+    ds3231_sleep_ms = ktime_ms_delta(ktime_get_boottime(), ds3231_suspended_at);
+
+    ret = ds3231_get_status(&ds3231_cache.tr, &st);
+    if (ret < 0) {
+        pr_err("DS3231: cannot read the control register on resume: %d\n", ret);
+    } else {
+        // The chip resets the control register when it loses both supplies. In high
+        // resolution mode suspend switched INTCN on, which is restored but not counted.
+        bool reset = st.ctl != ds3231_saved_ctl &&
+                     !(ds3231_hr.rate && st.ctl == (ds3231_saved_ctl | RTC_CTL_BIT_INTCN));
+
+        if (st.ctl != ds3231_saved_ctl) {
+            if (ds3231_set_ctl(&ds3231_cache.tr, ds3231_saved_ctl) < 0)
+                pr_err("DS3231: cannot restore the control register on resume\n");
+            else if (reset)
+                ds3231_ctl_restored++;
+        }
+        osf = st.status & RTC_STAT_BIT_OSF;
+        if (osf)
+            pr_warn("DS3231: oscillator stopped while suspended, time is not valid\n");
+        alarm = st.status & RTC_STAT_BIT_A1F;
+    }
+
+    WRITE_ONCE(ds3231_suspended, false);
+    if (alarm)
+        ds3231_wake_alarms++;
+
+    ds3231_resumes++;
+    ds3231_resume_us = ktime_us_delta(ktime_get(), start);
+    ds3231_max_resume_us = max(ds3231_max_resume_us, ds3231_resume_us);
+    DS3231_OpEnd();
+
+    // Handle and report the alarm that fired while suspended, and restart the sampler
+    if (alarm || osf)
+        queue_work(ds3231_wq, &ds3231_work);
+    if (READ_ONCE(drift_interval_ms))
+        ds3231_drift_kick();
+
+    return 0;
+}
+
+/* power management end */
+
+/* procfs start */
+
+#define PROCFS_MAX_SIZE 1024
+
+static struct proc_dir_entry *rtc_proc_file;
+
+static ssize_t rtc_proc_read(struct file *file, char __user *buffer, size_t len, loff_t *offset) {
+    
+    char *proc_buf;
+    int proc_buf_len;
+    struct ds3231_time tm;
+    ssize_t ret;
+    int fetch;
+
+    //Indicate the file has already been read
+    if (*offset > 0) {
+        return 0;
+    }
+    
+    //Allocate memory to buffer of size 1024,GFP-get free pages kernel (flag indicating memory allocation to kernel)
+    proc_buf = kmalloc(PROCFS_MAX_SIZE, GFP_KERNEL);
+    if (!proc_buf) {
+        return -ENOMEM;
+    }
+
+    //Print current time and date along with status of alarm on or off
+    DS3231_OpBegin(DS3231_OP_PROC_READ);
+    fetch = ds3231_get_time(&ds3231_cache.tr_stale, &tm);
+    if (fetch < 0) {
+        DS3231_OpEnd();
+        kfree(proc_buf);
+        return fetch;
+    }
+    proc_buf_len = snprintf(proc_buf, PROCFS_MAX_SIZE,
+      "Current RTC Time: %02u:%02u:%02u\nCurrent RTC Date: %02u/%02u/20%02u (Day of Week: %02u)\nAlarm1 status: %s\n%s",
+       tm.hour, tm.min, tm.sec, tm.date, tm.month, tm.year, tm.day, alarm1_status ? "Enable" : "Disable",
+       fetch == DS3231_STALE ? "Stale: yes\n" : "");
+    DS3231_OpEnd();
+
+    if (proc_buf_len < 0) {
+        kfree(proc_buf);
+        return -EFAULT;
+    }
+
+    //Copies data from kernel space to user space 
+    ret = simple_read_from_buffer(buffer, len, offset, proc_buf, proc_buf_len);
+
+    kfree(proc_buf);
+    return ret;
+}
+
+static const struct file_operations rtc_proc_fops = {
+    .owner = THIS_MODULE,
+    .read = rtc_proc_read,
+};
+
+/* procfs end */
+
+/* sysfs start */
+// Function to handle reading from the RTC through sysfs
+static ssize_t rtc_sysfs_show(struct kobject *kobj, struct kobj_attribute *attr, char *buf) {
+    struct ds3231_time tm;
+    ssize_t len;
+    int fetch;
+
+    printk(KERN_INFO "Sysfs - RTC Read!!!\n");
+
+    DS3231_OpBegin(DS3231_OP_SYSFS_RTC_SHOW);
+    fetch = ds3231_get_time(&ds3231_cache.tr_stale, &tm);
+    if (fetch < 0) {
+        DS3231_OpEnd();
+        return fetch;
+    }
+    len = sprintf(buf,"Current RTC Time: %02u:%02u:%02u\nCurrent RTC Date: %02u/%02u/20%02u (Day of Week: %02u)\n%s",
+       tm.hour, tm.min, tm.sec, tm.date, tm.month, tm.year, tm.day,
+       fetch == DS3231_STALE ? "Stale: yes\n" : "");
+    DS3231_OpEnd();
+
+    return len;
+}
+
+// Function to handle writing to the RTC through sysfs
+static ssize_t rtc_sysfs_store(struct kobject *kobj, struct kobj_attribute *attr, const char *buf, size_t count) {
+    int ret;
+    struct ds3231_time tm;
+
+    printk(KERN_INFO "Sysfs - RTC Write!!!\n");
+    
+    // Parse the input buffer to extract the new time and date values
+    ret = sscanf(buf, "set time: %u:%u:%u, set date: %u/%u/%u, day of week: %u",
+                 &tm.hour, &tm.min, &tm.sec, &tm.date, &tm.month, &tm.year, &tm.day);
+
+    // Check if the input format is correct
+    if (ret != 7) {
+        printk(KERN_ERR "Invalid time/date format\n");
+        return -EINVAL;
+    }
+
+    DS3231_OpBegin(DS3231_OP_SYSFS_RTC_STORE);
+    ret = DS3231_SetTime(&tm);
+    DS3231_OpEnd();
+
+    if (ret < 0)
+        return ret;
+    ds3231_alarm_rearm();
+    ds3231_notify_time_set(&tm);
+    return count;
+}
+
+
+// Define the RTC attribute for sysfs
+static struct kobj_attribute rtc_attr = __ATTR(rtc_time, 0660, rtc_sysfs_show, rtc_sysfs_store);
+
+// Function to handle reading from the RTC alarm through sysfs
+static ssize_t alarm_sysfs_show(struct kobject *kobj, struct kobj_attribute *attr, char *buf) {
+    
+    unsigned char set_sec, set_hour, set_min;
+    unsigned char alarm[4];
+    int fetch;
+    
+    printk(KERN_INFO "Sysfs - Alarm Read!!!\n");
+    
+    // Print the set alarm time
+    DS3231_OpBegin(DS3231_OP_SYSFS_ALARM_SHOW);
+    fetch = ds3231_get_alarm1(&ds3231_cache.tr_stale, alarm);
+    if (fetch < 0) {
+        DS3231_OpEnd();
+        return fetch;
+    }
+    set_sec = ds3231_bcd2bin(alarm[0] & ~RTC_A1M1);
+    set_min = ds3231_bcd2bin(alarm[1] & ~RTC_A1M2);
+    set_hour = ds3231_bcd2bin(alarm[2] & ~RTC_A1M3);
+    DS3231_OpEnd();
+
+    return sprintf(buf, "Alarm1 set for: %02x:%02x:%02x\n%s", ds3231_bin2bcd(set_hour), ds3231_bin2bcd(set_min), ds3231_bin2bcd(set_sec),
+                   fetch == DS3231_STALE ? "Stale: yes\n" : "");
+
+}
+
+// Function to handle setting the RTC alarm through sysfs
+static ssize_t alarm_sysfs_store(struct kobject *kobj, struct kobj_attribute *attr, const char *buf, size_t count) {
+    int ret;
+    unsigned int hour, min, sec;
+
+    printk(KERN_INFO "Sysfs - Alarm Write!!!\n");
+
+    ret = sscanf(buf, "set alarm1 after: %u:%u:%u", &hour, &min, &sec);
+    
+    // Define the RTC alarm attribute for sysfs
+    if (ret != 3) {
+        printk(KERN_ERR "Invalid time/date format\n");
+        return -EINVAL;
+    }
+    
+    DS3231_OpBegin(DS3231_OP_SYSFS_ALARM_STORE);
+    ret = DS3231_SetAlarm1After(hour, min, sec);
+    DS3231_OpEnd();
+
+    if (ret < 0)
+        return ret;
+
+    return count;
+}
+
+static struct kobj_attribute alarm_attr = __ATTR(alarm_time, 0660, alarm_sysfs_show, alarm_sysfs_store);
+
+// Function to read the alarm 1 rate and match values through sysfs
+static ssize_t alarm_mode_sysfs_show(struct kobject *kobj, struct kobj_attribute *attr, char *buf) {
+    unsigned int day, hour, min, sec;
+    unsigned char alarm[4];
+    bool repeat;
+    int fetch, mode;
+
+    DS3231_OpBegin(DS3231_OP_SYSFS_ALARM_MODE_SHOW);
+    fetch = ds3231_get_alarm1(&ds3231_cache.tr_stale, alarm);
+    if (fetch < 0) {
+        DS3231_OpEnd();
+        return fetch;
+    }
+    mode = ds3231_decode_alarm1(alarm, &day, &hour, &min, &sec);
+    repeat = alarm1_repeat;
+    DS3231_OpEnd();
+    if (mode < 0)
+        return mode;
+
+    return sprintf(buf, "Alarm1 mode: %s, day: %u, time: %02u:%02u:%02u, repeat: %s\n%s",
+                   ds3231_alarm_mode_names[mode], day, hour, min, sec, repeat ? "yes" : "no",
+                   fetch == DS3231_STALE ? "Stale: yes\n" : "");
+}
+
+// Function to set a recurring alarm through sysfs
+static ssize_t alarm_mode_sysfs_store(struct kobject *kobj, struct kobj_attribute *attr, const char *buf, size_t count) {
+    char name[16];
+    unsigned int mode, day, hour, min, sec;
+    int ret;
+
+    ret = sscanf(buf, "set alarm1 mode: %15[a-z_], day: %u, time: %u:%u:%u", name, &day, &hour, &min, &sec);
+    if (ret != 5) {
+        printk(KERN_ERR "Invalid alarm mode format\n");
+        return -EINVAL;
+    }
+    for (mode = 0; mode < DS3231_ALM_MODE_MAX; mode++) {
+        if (!strcmp(name, ds3231_alarm_mode_names[mode]))
+            break;
+    }
+    if (mode == DS3231_ALM_MODE_MAX)
+        return -EINVAL;
+
+    DS3231_OpBegin(DS3231_OP_SYSFS_ALARM_MODE_STORE);
+    ret = DS3231_SetAlarm1Mode(mode, day, hour, min, sec);
+    DS3231_OpEnd();
+
+    if (ret < 0)
+        return ret;
+    return count;
+}
+
+static struct kobj_attribute alarm_mode_attr = __ATTR(alarm_mode, 0660, alarm_mode_sysfs_show, alarm_mode_sysfs_store);
+
+// Function to read the pending absolute alarm through sysfs
+static ssize_t alarm_at_sysfs_show(struct kobject *kobj, struct kobj_attribute *attr, char *buf) {
+    time64_t target;
+
+    DS3231_OpBegin(DS3231_OP_SYSFS_ALARM_AT_SHOW);
+    target = alarm1_target;
+    DS3231_OpEnd();
+
+    if (!target)
+        return sprintf(buf, "Alarm1 at: none\n");
+    return sprintf(buf, "Alarm1 at: %lld\n", (long long)target);
+}
+
+// Function to set an absolute alarm through sysfs, RTC time in seconds since the epoch
+static ssize_t alarm_at_sysfs_store(struct kobject *kobj, struct kobj_attribute *attr, const char *buf, size_t count) {
+    long long target;
+    int ret;
+
+    if (sscanf(buf, "set alarm1 at: %lld", &target) != 1) {
+        printk(KERN_ERR "Invalid alarm time format\n");
+        return -EINVAL;
+    }
+
+    DS3231_OpBegin(DS3231_OP_SYSFS_ALARM_AT_STORE);
+    ret = DS3231_ArmAlarm1Abs(target);
+    DS3231_OpEnd();
+
+    if (ret < 0)
+        return ret;
+    return count;
+}
+
+static struct kobj_attribute alarm_at_attr = __ATTR(alarm_at, 0660, alarm_at_sysfs_show, alarm_at_sysfs_store);
+
+// Function to report per-operation I2C transaction counts against their budgets
+static ssize_t stats_sysfs_show(struct kobject *kobj, struct kobj_attribute *attr, char *buf) {
+    ssize_t len = 0;
+
+    mutex_lock(&ds3231_bus_lock);
+    len += scnprintf(buf + len, PAGE_SIZE - len, "bulk_reads=%lu coalesced=%lu\n",
+                     ds3231_cache.bulk_reads, ds3231_cache.coalesced);
+    len += scnprintf(buf + len, PAGE_SIZE - len,
+                     "retries=%lu failures=%lu fast_fails=%lu stale_served=%lu breaker=%s\n",
+                     ds3231_retries, ds3231_failures, ds3231_fast_fails, ds3231_cache.stale_served,
+                     ds3231_breaker_open ? "open" : "closed");
+    len += scnprintf(buf + len, PAGE_SIZE - len,
+                     "suspends=%lu resumes=%lu suspend_us=%lld max_suspend_us=%lld resume_us=%lld max_resume_us=%lld sleep_ms=%lld wake_alarms=%lu ctl_restored=%lu wakeup=%s\n",
+                     ds3231_suspends, ds3231_resumes, ds3231_suspend_us, ds3231_max_suspend_us,
+                     ds3231_resume_us, ds3231_max_resume_us, ds3231_sleep_ms, ds3231_wake_alarms,
+                     ds3231_ctl_restored,
+                     rtc_i2c_client && device_may_wakeup(&rtc_i2c_client->dev) ? "enabled" : "disabled");
+    mutex_unlock(&ds3231_bus_lock);
+
+    return len;
+}
+
+// Function to reset the statistics, e.g. before a benchmark run
+static ssize_t stats_sysfs_store(struct kobject *kobj, struct kobj_attribute *attr, const char *buf, size_t count) {
+    if (!sysfs_streq(buf, "reset"))
+        return -EINVAL;
+
+    mutex_lock(&ds3231_bus_lock);
+    memset(ds3231_stats, 0, sizeof(ds3231_stats));
+    ds3231_cache.bulk_reads = 0;
+    ds3231_cache.coalesced = 0;
+    ds3231_retries = 0;
+    ds3231_failures = 0;
+    ds3231_fast_fails = 0;
+    ds3231_cache.stale_served = 0;
+    ds3231_suspends = 0;
+    ds3231_resumes = 0;
+    ds3231_max_suspend_us = 0;
+    ds3231_max_resume_us = 0;
+    ds3231_wake_alarms = 0;
+    ds3231_ctl_restored = 0;
+    mutex_unlock(&ds3231_bus_lock);
+
+    return count;
+}
+
+static struct kobj_attribute stats_attr = __ATTR(stats, 0660, stats_sysfs_show, stats_sysfs_store);
+
+// Function to report the I2C traffic of every operation against its budget, one row per
+// operation. Even with every counter at its widest the table stays within the page.
+static ssize_t budgets_sysfs_show(struct kobject *kobj, struct kobj_attribute *attr, char *buf) {
+    ssize_t len;
+    int op;
+
+    len = scnprintf(buf, PAGE_SIZE, "op calls xfers bytes max_xfers max_bytes budget_xfers budget_bytes violations\n");
+    mutex_lock(&ds3231_bus_lock);
+    for (op = 0; op < DS3231_OP_MAX; op++) {
+        const struct ds3231_op_budget *budget = &ds3231_budgets[op];
+        const struct ds3231_op_stats *st = &ds3231_stats[op];
+
+        len += scnprintf(buf + len, PAGE_SIZE - len, "%s %lu %lu %lu %u %u %u %u %lu\n",
+                         budget->name, st->calls, st->xfers, st->bytes, st->max_xfers, st->max_bytes,
+                         budget->max_xfers, budget->max_bytes, st->violations);
+    }
+    mutex_unlock(&ds3231_bus_lock);
+
+    return len;
+}
+
+static struct kobj_attribute budgets_attr = __ATTR(budgets, 0444, budgets_sysfs_show, NULL);
+
+// Function to report the square wave counting and the CPU time its interrupts take
+static ssize_t hires_sysfs_show(struct kobject *kobj, struct kobj_attribute *attr, char *buf) {
+    struct ds3231_hr hr;
+    unsigned int seq;
+    u64 now, elapsed;
+
+    do {
+        seq = read_seqbegin(&ds3231_hr_lock);
+        hr = ds3231_hr;
+        now = ktime_get_boot_ns();
+    } while (read_seqretry(&ds3231_hr_lock, seq));
+
+    if (!hr.rate)
+        return sprintf(buf, "rate=0\n");
+
+    // cpu_ppm is the share of one CPU spent in the handler, without the interrupt entry and exit
+    elapsed = max_t(u64, now - hr.since_ns, 1);
+    return sprintf(buf, "rate=%u irqs=%llu missed=%llu resyncs=%lu irq_ns_avg=%llu irq_ns_max=%llu cpu_ppm=%llu\n",
+                   hr.rate, hr.irqs, hr.missed, hr.resyncs,
+                   hr.irqs ? div64_u64(hr.irq_ns, hr.irqs) : 0, hr.max_irq_ns,
+                   div64_u64(hr.irq_ns * 1000000, elapsed));
+}
+
+// Function to switch to another square wave rate, which also resets the counters
+static ssize_t hires_sysfs_store(struct kobject *kobj, struct kobj_attribute *attr, const char *buf, size_t count) {
+    unsigned int rate;
+    int ret;
+
+    if (kstrtouint(buf, 10, &rate))
+        return -EINVAL;
+    // Turning the mode on or off moves the alarm off or back onto the pin, only done at load
+    if (!READ_ONCE(ds3231_hr.rate))
+        return -EPERM;
+
+    DS3231_OpBegin(DS3231_OP_HIRES_RATE);
+    ret = ds3231_hr_set_rate(rate);
+    DS3231_OpEnd();
+
+    if (ret < 0)
+        return ret;
+    return count;
+}
+
+static struct kobj_attribute hires_attr = __ATTR(hires, 0660, hires_sysfs_show, hires_sysfs_store);
+
+static int irq_latency_stage_show(char *buf, int len, const char *name, const struct ds3231_lat_stage *st)
+{
+    int i;
+
+    len += scnprintf(buf + len, PAGE_SIZE - len, "%s: count=%lu min_ns=%llu avg_ns=%llu max_ns=%llu hist=",
+                     name, st->count, st->min_ns, st->count ? div64_u64(st->sum_ns, st->count) : 0,
+                     st->max_ns);
+    for (i = 0; i < DS3231_LAT_BUCKETS; i++)
+        len += scnprintf(buf + len, PAGE_SIZE - len, "%lu%c", st->hist[i],
+                         i == DS3231_LAT_BUCKETS - 1 ? '\n' : ',');
+    return len;
+}
+
+// Function to report the alarm path latency, hist counts are for [2^i, 2^(i+1)) nanoseconds
+static ssize_t irq_latency_sysfs_show(struct kobject *kobj, struct kobj_attribute *attr, char *buf) {
+    struct ds3231_lat_stage irq_work, work_event;
+    unsigned long irqs, coalesced, works, alarms;
+    int len;
+
+    spin_lock_irq(&ds3231_lat_lock);
+    irqs = ds3231_lat.irqs;
+    coalesced = ds3231_lat.coalesced;
+    works = ds3231_lat.works;
+    alarms = ds3231_lat.alarms;
+    irq_work = ds3231_lat.irq_work;
+    work_event = ds3231_lat.work_event;
+    spin_unlock_irq(&ds3231_lat_lock);
+
+    len = scnprintf(buf, PAGE_SIZE, "irqs=%lu coalesced=%lu works=%lu alarms=%lu\n",
+                    irqs, coalesced, works, alarms);
+    len = irq_latency_stage_show(buf, len, "irq_work", &irq_work);
+    return irq_latency_stage_show(buf, len, "work_event", &work_event);
+}
+
+// Function to reset the alarm path latency, e.g. before a benchmark run
+static ssize_t irq_latency_sysfs_store(struct kobject *kobj, struct kobj_attribute *attr, const char *buf, size_t count) {
+    if (!sysfs_streq(buf, "reset"))
+        return -EINVAL;
+
+    spin_lock_irq(&ds3231_lat_lock);
+    memset(&ds3231_lat, 0, sizeof(ds3231_lat));
+    spin_unlock_irq(&ds3231_lat_lock);
+
+    return count;
+}
+
+static struct kobj_attribute irq_latency_attr = __ATTR(irq_latency, 0660, irq_latency_sysfs_show, irq_latency_sysfs_store);
+/* sysfs end */
+
+/* IOCTL start*/
+
+// Structure to hold RTC time and date values
+struct rtc_value {
+	unsigned char usr_hour, usr_min, usr_sec;
+	unsigned char usr_day, usr_date, usr_month, usr_year;
+};
+
+// Structure to hold alarm time values
+struct alm_value {
+	unsigned char alm_hour, alm_min, alm_sec;
+};
+
+// Structure to hold a recurring alarm, alm_mode is an enum ds3231_alarm_mode. alm_day is the
+// date for DS3231_ALM_MATCH_DATE and the day of week for DS3231_ALM_MATCH_DAY.
+struct alm_mode_value {
+	unsigned char alm_mode;
+	unsigned char alm_day, alm_hour, alm_min, alm_sec;
+};
+
+// Structure to hold an absolute alarm, RTC time in seconds since the epoch, 0 for none
+struct alm_abs_value {
+	__s64 alm_time;
+};
+
+// Structure to hold the control and status registers, the die temperature in 0.25 C steps
+// and the alarm 1 state
+struct rtc_status_value {
+	unsigned char ctl, status;
+	__s16 temp_qc;
+	unsigned char alm1_enabled, alm1_repeat;
+};
+
+// Structure to hold the RTC time with the fraction counted from the square wave, and the
+// square wave rate, which bounds its resolution
+struct rtc_hr_value {
+	__s64 sec;
+	__u32 nsec;
+	__u32 rate;
+};
+
+// IOCTL commands for RTC operations
+#define WR_RTC_TIME _IOW('a', 1, struct rtc_value)
+#define RD_RTC_TIME _IOR('a', 2, struct rtc_value)
+#define WR_ALM1_TIME _IOW('a', 3,struct alm_value)
+#define RD_ALM1_TIME _IOR('a', 4, struct alm_value)
+#define WR_ALM1_MODE _IOW('a', 5, struct alm_mode_value)
+#define RD_ALM1_MODE _IOR('a', 6, struct alm_mode_value)
+#define WR_ALM1_ABS _IOW('a', 7, struct alm_abs_value)
+#define RD_ALM1_ABS _IOR('a', 8, struct alm_abs_value)
+#define RD_RTC_STATUS _IOR('a', 9, struct rtc_status_value)
+#define REG_ALM1_EVENTFD _IOW('a', 10, int)
+#define RD_RTC_TIME_HR _IOR('a', 11, struct rtc_hr_value)
+
+// Device number and class
+dev_t dev = 0;
+static struct class *dev_class;
+static struct cdev etx_cdev;
+
+// Function prototypes for file operations
+static int rtc_open(struct inode *inode, struct file *file);
+static int rtc_release(struct inode *inode, struct file *file);
+static ssize_t rtc_read(struct file *filp, char __user *buf, size_t len,loff_t * off);
+static ssize_t rtc_write(struct file *filp, const char *buf, size_t len, loff_t * off);
+static long rtc_ioctl(struct file *file, unsigned int cmd, unsigned long arg);
+static int rtc_mmap(struct file *file, struct vm_area_struct *vma);
+static __poll_t rtc_poll(struct file *file, poll_table *wait);
+static int rtc_fasync(int fd, struct file *file, int on);
+
+// File operations structure
+static struct file_operations fops =
+{
+	.owner          = THIS_MODULE,
+	.read           = rtc_read,
+	.write          = rtc_write,
+	.open           = rtc_open,
+	.unlocked_ioctl = rtc_ioctl,
+	.mmap           = rtc_mmap,
+	.poll           = rtc_poll,
+	.fasync         = rtc_fasync,
+	.release        = rtc_release,
+};
+
+// Open function for the device file
+static int rtc_open(struct inode *inode, struct file *file)
+{
+	struct ds3231_file *df = kzalloc(sizeof(*df), GFP_KERNEL);
+
+	if (!df)
+		return -ENOMEM;
+	file->private_data = df;
+	printk(KERN_INFO "Device File Opened...!!!\n");
+	// Readers only see events queued after open
+	file->f_pos = READ_ONCE(ds3231_evq_head);
+	return 0;
+}
+
+// Map the drift telemetry ring buffer into userspace: the header and samples read-only at
+// offset 0, the reader's tail page read/write at tail_offset
+static int rtc_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	unsigned long size = vma->vm_end - vma->vm_start;
+
+	if (!ds3231_drift_ring)
+		return -ENODEV;
+
+	if (vma->vm_pgoff == ds3231_drift_size >> PAGE_SHIFT) {
+		// Shared, or the driver would never see the reader's tail
+		if (size != PAGE_SIZE || !(vma->vm_flags & VM_SHARED))
+			return -EINVAL;
+		return remap_vmalloc_range(vma, ds3231_drift_tail, 0);
+	}
+
+	if (vma->vm_pgoff || size > ds3231_drift_size)
+		return -EINVAL;
+	if (vma->vm_flags & VM_WRITE)
+		return -EPERM;
+	vma->vm_flags &= ~VM_MAYWRITE;
+	return remap_vmalloc_range(vma, ds3231_drift_ring, 0);
+}
+
+// Release function for the device file
+static int rtc_release(struct inode *inode, struct file *file)
+{
+	struct ds3231_file *df = file->private_data;
+	struct ds3231_efd *efd = df->efd;
+
+	// The VFS has already dropped a SIGIO registration, only the eventfd is left
+	if (efd) {
+		mutex_lock(&ds3231_efd_lock);
+		list_del(&efd->node);
+		mutex_unlock(&ds3231_efd_lock);
+		eventfd_ctx_put(efd->ctx);
+		kfree(efd);
+	}
+	if (test_bit(0, &df->listening))
+		atomic_dec(&ds3231_evq_readers);
+	kfree(df);
+	printk(KERN_INFO "Device File Closed...!!!\n");
+	return 0;
+}
+
+// Read function for the device file, returns whole struct ds3231_event_rec records and blocks
+// until at least one event is queued unless the file is non-blocking
+static ssize_t rtc_read(struct file *filp, char __user *buf, size_t len, loff_t *off)
+{
+	struct ds3231_event_rec rec;
+	ssize_t done = 0;
+	u32 pos, head;
+	int ret;
+
+	if (len < sizeof(rec))
+		return -EINVAL;
+	ds3231_evq_listen(filp);
+
+retry:
+	if (!ds3231_evq_pending(*off)) {
+		if (filp->f_flags & O_NONBLOCK)
+			return -EAGAIN;
+		ret = wait_event_interruptible(ds3231_evq_wait, ds3231_evq_pending(*off));
+		if (ret)
+			return ret;
+	}
+
+	while (done + sizeof(rec) <= len) {
+		spin_lock(&ds3231_evq_lock);
+		pos = *off;
+		head = ds3231_evq_head;
+		if (pos == head) {
+			spin_unlock(&ds3231_evq_lock);
+			break;
+		}
+		if (head - pos > DS3231_EVQ_LEN)
+			pos = head - DS3231_EVQ_LEN;
+		rec = ds3231_evq[pos & (DS3231_EVQ_LEN - 1)];
+		spin_unlock(&ds3231_evq_lock);
+
+		if (copy_to_user(buf + done, &rec, sizeof(rec)))
+			return done ? done : -EFAULT;
+		*off = pos + 1;
+		done += sizeof(rec);
+	}
+	// Another reader of the same file took the events first
+	if (!done)
+		goto retry;
+	return done;
+}
+
+// Poll function for the device file, readable while events are queued for this file
+static __poll_t rtc_poll(struct file *file, poll_table *wait)
+{
+	ds3231_evq_listen(file);
+	poll_wait(file, &ds3231_evq_wait, wait);
+	return ds3231_evq_pending(file->f_pos) ? EPOLLIN | EPOLLRDNORM : 0;
+}
+
+// O_ASYNC on the device file: SIGIO whenever events become readable
+static int rtc_fasync(int fd, struct file *file, int on)
+{
+	if (on)
+		ds3231_evq_listen(file);
+	return fasync_helper(fd, file, on, &ds3231_fasync);
+}
+
+// Register an eventfd for this open file, signalled once per alarm 1 match. A negative fd
+// drops the registration, as does closing the device file.
+static int rtc_set_eventfd(struct file *file, int fd)
+{
+	struct ds3231_file *df = file->private_data;
+	struct ds3231_efd *efd = NULL, *old;
+	struct eventfd_ctx *ctx;
+
+	if (fd >= 0) {
+		ctx = eventfd_ctx_fdget(fd);
+		if (IS_ERR(ctx))
+			return PTR_ERR(ctx);
+		efd = kzalloc(sizeof(*efd), GFP_KERNEL);
+		if (!efd) {
+			eventfd_ctx_put(ctx);
+			return -ENOMEM;
+		}
+		efd->ctx = ctx;
+		ds3231_evq_listen(file);
+	}
+
+	mutex_lock(&ds3231_efd_lock);
+	old = df->efd;
+	if (old)
+		list_del(&old->node);
+	if (efd)
+		list_add_tail(&efd->node, &ds3231_efd_list);
+	df->efd = efd;
+	mutex_unlock(&ds3231_efd_lock);
+
+	if (old) {
+		eventfd_ctx_put(old->ctx);
+		kfree(old);
+	}
+	return 0;
+}
+
+// Write function for the device file
+static ssize_t rtc_write(struct file *filp, const char __user *buf, size_t len, loff_t *off)
+{
+	printk(KERN_INFO "Write function\n");
+	return 0;
+}
+
+// IOCTL function for handling IOCTL commands
+// Read commands return DS3231_STALE instead of 0 when they served cached values after a bus failure
+static long rtc_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
+{
+    long ret = 0;
+
+    printk(KERN_INFO "IOCTL function\n");
+    switch (cmd) {
+
+	case WR_RTC_TIME:
+	{ 
+            struct rtc_value data;
+            struct ds3231_time tm;
+	    
+	    // Copy RTC time and date values from user space
+	    if (copy_from_user(&data, (struct rtc_value *)arg, sizeof(struct rtc_value))) {
+                return -EFAULT;
+            }
+            tm.hour = data.usr_hour;
+            tm.min = data.usr_min;
+            tm.sec = data.usr_sec;
+            tm.day = data.usr_day;
+            tm.date = data.usr_date;
+            tm.month = data.usr_month;
+            tm.year = data.usr_year;
+            
+	    DS3231_OpBegin(DS3231_OP_IOCTL_WR_TIME);
+    
+	    // Set DS3231 time and date to the values from user space
+    	    ret = DS3231_SetTime(&tm);
+    	    if (ret < 0) {
+        	pr_err("Failed to set time\n");
+                DS3231_OpEnd();
+                return ret;
+    	    }
+	    DS3231_OpEnd();
+
+	    ds3231_alarm_rearm();
+	    ds3231_notify_time_set(&tm);
+
+	    pr_info("Current time is updated");
+        
+	}
+	    break;
+
+	case RD_RTC_TIME:
+	{   
+            struct rtc_value data;
+            struct ds3231_time tm;
+	    
+	    //read RTC time and date values
+	    DS3231_OpBegin(DS3231_OP_IOCTL_RD_TIME);
+    	    ret = ds3231_get_time(&ds3231_cache.tr_stale, &tm);
+	    DS3231_OpEnd();
+    	    if (ret < 0)
+    	        return ret;
+
+	    // The ioctl returns the registers in BCD
+	    data.usr_hour = ds3231_bin2bcd(tm.hour);
+	    data.usr_min = ds3231_bin2bcd(tm.min);
+	    data.usr_sec = ds3231_bin2bcd(tm.sec);
+	    data.usr_day = ds3231_bin2bcd(tm.day);
+	    data.usr_date = ds3231_bin2bcd(tm.date);
+	    data.usr_month = ds3231_bin2bcd(tm.month);
+	    data.usr_year = ds3231_bin2bcd(tm.year);
+
+	    // Copy RTC time and date values to user space
+    	    if (copy_to_user((struct rtc_value *)arg, &data, sizeof(struct rtc_value))) {
+                return -EFAULT;
+    	    }
+	    pr_info("Time Read by user"); 
+    	}
+	    break;
+	
+	case WR_ALM1_TIME:
+	{ 
+            struct alm_value data;
+	    unsigned char alm_hour, alm_min, alm_sec;
+	    
+	    // Copy alarm time values from user space
+	    if (copy_from_user(&data, (struct alm_value *)arg, sizeof(struct alm_value))) {
+                return -EFAULT;
+            }
+            
+	    alm_hour = data.alm_hour;
+	    alm_min = data.alm_min;
+	    alm_sec = data.alm_sec;
+    
+	    // Set alarm from
+	    DS3231_OpBegin(DS3231_OP_IOCTL_WR_ALARM1);
+    	    ret = DS3231_SetAlarm1After(alm_hour, alm_min, alm_sec);
+	    DS3231_OpEnd();
+	    if (ret < 0)
+	        return ret;
+    
+	    pr_info("Alarm1 is set");
+        
+	}
+	    break;
+
+	case RD_ALM1_TIME:
+	{   
+            struct alm_value data;
+            unsigned char alarm[4];
+    
+	    // Read alarm time values
+	    DS3231_OpBegin(DS3231_OP_IOCTL_RD_ALARM1);
+	    ret = ds3231_get_alarm1(&ds3231_cache.tr_stale, alarm);
+	    if (ret < 0) {
+	        DS3231_OpEnd();
+	        return ret;
+	    }
+	    data.alm_sec = ds3231_bcd2bin(alarm[0] & ~RTC_A1M1);
+    	    data.alm_min  = ds3231_bcd2bin(alarm[1] & ~RTC_A1M2);
+      	    data.alm_hour  = ds3231_bcd2bin(alarm[2] & ~RTC_A1M3);
+	    DS3231_OpEnd();
+    	    
+    	    pr_info("Alarm 1 set for: %02x:%02x:%02x\n", ds3231_bin2bcd(data.alm_hour), ds3231_bin2bcd(data.alm_min), ds3231_bin2bcd(data.alm_sec));
+
+	    // Copy alarm time values to user space
+    	    if (copy_to_user((struct alm_value *)arg, &data, sizeof(struct alm_value))) {
+                return -EFAULT;
+    	    }
+	    pr_info("Alarm1 Read"); 
+    	}
+	    break;
+
+	case WR_ALM1_MODE:
+	{
+            struct alm_mode_value data;
+
+	    if (copy_from_user(&data, (struct alm_mode_value *)arg, sizeof(struct alm_mode_value))) {
+                return -EFAULT;
+            }
+
+	    DS3231_OpBegin(DS3231_OP_IOCTL_WR_ALM1_MODE);
+	    ret = DS3231_SetAlarm1Mode(data.alm_mode, data.alm_day, data.alm_hour, data.alm_min, data.alm_sec);
+	    DS3231_OpEnd();
+	    if (ret < 0)
+	        return ret;
+	}
+	    break;
+
+	case RD_ALM1_MODE:
+	{
+            struct alm_mode_value data;
+	    unsigned int day, hour, min, sec;
+	    unsigned char alarm[4];
+	    int mode;
+
+	    DS3231_OpBegin(DS3231_OP_IOCTL_RD_ALM1_MODE);
+	    ret = ds3231_get_alarm1(&ds3231_cache.tr_stale, alarm);
+	    if (ret < 0) {
+	        DS3231_OpEnd();
+	        return ret;
+	    }
+	    mode = ds3231_decode_alarm1(alarm, &day, &hour, &min, &sec);
+	    DS3231_OpEnd();
+	    if (mode < 0)
+	        return mode;
+
+	    data.alm_mode = mode;
+	    data.alm_day = day;
+	    data.alm_hour = hour;
+	    data.alm_min = min;
+	    data.alm_sec = sec;
+    	    if (copy_to_user((struct alm_mode_value *)arg, &data, sizeof(struct alm_mode_value))) {
+                return -EFAULT;
+    	    }
+	}
+	    break;
+
+	case WR_ALM1_ABS:
+	{
+            struct alm_abs_value data;
+
+	    if (copy_from_user(&data, (struct alm_abs_value *)arg, sizeof(struct alm_abs_value))) {
+                return -EFAULT;
+            }
+
+	    DS3231_OpBegin(DS3231_OP_IOCTL_WR_ALM1_ABS);
+	    ret = DS3231_ArmAlarm1Abs(data.alm_time);
+	    DS3231_OpEnd();
+	    if (ret < 0)
+	        return ret;
+	}
+	    break;
+
+	case RD_ALM1_ABS:
+	{
+            struct alm_abs_value data;
+
+	    DS3231_OpBegin(DS3231_OP_IOCTL_RD_ALM1_ABS);
+	    data.alm_time = alarm1_target;
+	    DS3231_OpEnd();
+
+    	    if (copy_to_user((struct alm_abs_value *)arg, &data, sizeof(struct alm_abs_value))) {
+                return -EFAULT;
+    	    }
+	}
+	    break;
+
+	case RD_RTC_STATUS:
+	{
+            struct rtc_status_value data;
+            struct ds3231_status st;
+
+	    DS3231_OpBegin(DS3231_OP_IOCTL_RD_STATUS);
+	    ret = ds3231_get_status(&ds3231_cache.tr_stale, &st);
+	    if (ret < 0) {
+	        DS3231_OpEnd();
+	        return ret;
+	    }
+	    data.ctl = st.ctl;
+	    data.status = st.status;
+	    data.temp_qc = st.temp_qc;
+	    data.alm1_enabled = alarm1_status;
+	    data.alm1_repeat = alarm1_repeat;
+	    DS3231_OpEnd();
+
+    	    if (copy_to_user((struct rtc_status_value *)arg, &data, sizeof(struct rtc_status_value))) {
+                return -EFAULT;
+    	    }
+	}
+	    break;
+
+	case RD_RTC_TIME_HR:
+	{
+            struct rtc_hr_value data;
+            time64_t sec;
+
+	    // Served from the edge count, no bus access
+	    ret = ds3231_hr_read(&sec, &data.nsec, &data.rate);
+	    if (ret < 0)
+	        return ret;
+	    data.sec = sec;
+
+    	    if (copy_to_user((struct rtc_hr_value *)arg, &data, sizeof(struct rtc_hr_value))) {
+                return -EFAULT;
+    	    }
+	}
+	    break;
+
+	case REG_ALM1_EVENTFD:
+	{
+            int fd;
+
+    	    if (copy_from_user(&fd, (int *)arg, sizeof(fd))) {
+                return -EFAULT;
+    	    }
+	    ret = rtc_set_eventfd(file, fd);
+	}
+	    break;
+
+        default:
+	    pr_info("invalid IOCTL command from user");
+            return -ENOTTY;
+    }
+	return ret;
+}
+
+/* IOCTL end */
+
+static int __init ds3231_init(void)
+{
+    int ret = -1;
+    int status;
+    struct ds3231_status st;
+
+    // Every register access goes through the cache, from the first one at probe on
+    ds3231_cache_init(&ds3231_cache, &ds3231_bus);
+    ds3231_cache.take_pending = DS3231_TakePending;
+
+        //IOCTL init start
+        if((alloc_chrdev_region(&dev, 0, 1, SLAVE_DEVICE_NAME)) <0) {
+		printk(KERN_INFO "Cannot allocate major number\n");
+		return -1;
+	}
+	printk(KERN_INFO "Major = %d Minor = %d \n",MAJOR(dev), MINOR(dev));
+
+	/* Creating cdev structure */
+	cdev_init(&etx_cdev, &fops);
+
+	/* Adding character device to the system */
+	if((cdev_add(&etx_cdev, dev, 1)) < 0) {
+		printk(KERN_INFO "Cannot add the device to the system\n");
+		goto r_cdev;
+	}
+
+	/* Creating struct class */
+	if((dev_class = class_create(THIS_MODULE, CLASS_NAME)) == NULL) {
+		printk(KERN_INFO "Cannot create the struct class\n");
+		goto r_class;
+	}
+
+	/* Creating device */
+	if((device_create(dev_class, NULL, dev, NULL, SLAVE_DEVICE_NAME)) == NULL) {
+		printk(KERN_INFO "Cannot create the Device 1\n");
+		goto r_device;
+	}
+        //IOCTL init end
+
+    //sysfs init starit-Creating a directory in /sys/kernel/ 
+    kobj_ref = kobject_create_and_add("rtc_sysfs", kernel_kobj);
+    if (!kobj_ref) {
+        printk(KERN_ERR "Failed to create kobject\n");
+        ret = -ENOMEM;
+        goto r_sysfs;
+    }
+    //Creating sysfs file
+    ret = sysfs_create_file(kobj_ref, &rtc_attr.attr);
+    if (ret) {
+        printk(KERN_ERR "Failed to create rtc_time sysfs file\n");
+        kobject_put(kobj_ref);
+        goto r_sysfs;
+    }
+
+    ret = sysfs_create_file(kobj_ref, &alarm_attr.attr);
+    if (ret) {
+        printk(KERN_ERR "Failed to create alarm_time sysfs file\n");
+        sysfs_remove_file(kobj_ref, &rtc_attr.attr);
+        kobject_put(kobj_ref);
+        goto r_sysfs;
+    }
+
+    ret = sysfs_create_file(kobj_ref, &stats_attr.attr);
+    if (ret) {
+        printk(KERN_ERR "Failed to create stats sysfs file\n");
+        sysfs_remove_file(kobj_ref, &alarm_attr.attr);
+        sysfs_remove_file(kobj_ref, &rtc_attr.attr);
+        kobject_put(kobj_ref);
+        goto r_sysfs;
+    }
+
+    ret = sysfs_create_file(kobj_ref, &alarm_mode_attr.attr);
+    if (ret) {
+        printk(KERN_ERR "Failed to create alarm_mode sysfs file\n");
+        sysfs_remove_file(kobj_ref, &stats_attr.attr);
+        sysfs_remove_file(kobj_ref, &alarm_attr.attr);
+        sysfs_remove_file(kobj_ref, &rtc_attr.attr);
+        kobject_put(kobj_ref);
+        goto r_sysfs;
+    }
+
+    ret = sysfs_create_file(kobj_ref, &alarm_at_attr.attr);
+    if (ret) {
+        printk(KERN_ERR "Failed to create alarm_at sysfs file\n");
+        sysfs_remove_file(kobj_ref, &alarm_mode_attr.attr);
+        sysfs_remove_file(kobj_ref, &stats_attr.attr);
+        sysfs_remove_file(kobj_ref, &alarm_attr.attr);
+        sysfs_remove_file(kobj_ref, &rtc_attr.attr);
+        kobject_put(kobj_ref);
+        goto r_sysfs;
+    }
+
+    ret = sysfs_create_file(kobj_ref, &hires_attr.attr);
+    if (ret) {
+        printk(KERN_ERR "Failed to create hires sysfs file\n");
+        sysfs_remove_file(kobj_ref, &alarm_at_attr.attr);
+        sysfs_remove_file(kobj_ref, &alarm_mode_attr.attr);
+        sysfs_remove_file(kobj_ref, &stats_attr.attr);
+        sysfs_remove_file(kobj_ref, &alarm_attr.attr);
+        sysfs_remove_file(kobj_ref, &rtc_attr.attr);
+        kobject_put(kobj_ref);
+        goto r_sysfs;
+    }
+
+    ret = sysfs_create_file(kobj_ref, &irq_latency_attr.attr);
+    if (ret) {
+        printk(KERN_ERR "Failed to create irq_latency sysfs file\n");
+        sysfs_remove_file(kobj_ref, &hires_attr.attr);
+        sysfs_remove_file(kobj_ref, &alarm_at_attr.attr);
+        sysfs_remove_file(kobj_ref, &alarm_mode_attr.attr);
+        sysfs_remove_file(kobj_ref, &stats_attr.attr);
+        sysfs_remove_file(kobj_ref, &alarm_attr.attr);
+        sysfs_remove_file(kobj_ref, &rtc_attr.attr);
+        kobject_put(kobj_ref);
+        goto r_sysfs;
+    }
+
+    ret = sysfs_create_file(kobj_ref, &budgets_attr.attr);
+    if (ret) {
+        printk(KERN_ERR "Failed to create budgets sysfs file\n");
+        sysfs_remove_file(kobj_ref, &irq_latency_attr.attr);
+        sysfs_remove_file(kobj_ref, &hires_attr.attr);
+        sysfs_remove_file(kobj_ref, &alarm_at_attr.attr);
+        sysfs_remove_file(kobj_ref, &alarm_mode_attr.attr);
+        sysfs_remove_file(kobj_ref, &stats_attr.attr);
+        sysfs_remove_file(kobj_ref, &alarm_attr.attr);
+        sysfs_remove_file(kobj_ref, &rtc_attr.attr);
+        kobject_put(kobj_ref);
+        goto r_sysfs;
+    }
+    //sysfs init end
+
+    // procfs init start
+    rtc_proc_file = proc_create("rtc_time", 0444, NULL, &rtc_proc_fops);
+    if (!rtc_proc_file) {
+        ret = -ENOMEM;
+        goto r_proc;
+    }
+    //procfs init end
+    
+    rtc_i2c_adapter = i2c_get_adapter(I2C_BUS_AVAILABLE);
+    pr_info("Init Started");
+    if (rtc_i2c_adapter != NULL) {
+        rtc_i2c_client = i2c_new_device(rtc_i2c_adapter, &rtc_i2c_board_info);
+        
+        if (rtc_i2c_client != NULL) {
+            i2c_add_driver(&ds3231_driver);
+            ret = 0;
+        }
+        
+        i2c_put_adapter(rtc_i2c_adapter);
+    }
+
+     // Initialize the workqueue
+    ds3231_wq = create_singlethread_workqueue("ds3231_wq");
+    if (!ds3231_wq) {
+        pr_err("Failed to create workqueue\n");
+        ret = -ENOMEM;
+        goto r_wq;
+    }
+    INIT_WORK(&ds3231_work, ds3231_work_handler);
+
+    // Drift telemetry is optional, the driver works without it
+    if (ds3231_drift_init() < 0)
+        pr_err("Failed to allocate the drift ring buffer\n");
+
+    // So are netlink events
+    if (genl_register_family(&ds3231_genl_family) < 0)
+        pr_err("Failed to register the DS3231 generic netlink family\n");
+    else
+        ds3231_genl_registered = true;
+
+   if (alarm_irq >= 0) {
+     // IRQ given directly, no GPIO to set up
+     GPIO_irqNumber = alarm_irq;
+   } else {
+     //Input GPIO configuration
+     //Checking the GPIO is valid or not
+     if(gpio_is_valid(alarm_gpio) == false){
+       pr_err("GPIO %d is not valid\n", alarm_gpio);
+       ret = -EINVAL;
+       goto r_gpio;
+     }
+     pr_info("GPIO valid");
+
+     //Requesting the GPIO
+     ret = gpio_request(alarm_gpio,"GPIO_INT_PIN");
+     if(ret < 0){
+       pr_err("ERROR: GPIO %d request\n",alarm_gpio);
+       goto r_gpio;
+     }
+     pr_info("IRQ request accept");
+
+     //configure the GPIO as input
+     gpio_direction_input(alarm_gpio);
+
+     //Get the IRQ number for our GPIO
+     GPIO_irqNumber = gpio_to_irq(alarm_gpio);
+     if (GPIO_irqNumber < 0) {
+       pr_err("GPIO %d has no IRQ\n", alarm_gpio);
+       ret = GPIO_irqNumber;
+       goto r_gpio_in;
+     }
+   }
+   pr_info("GPIO_irqNumber = %d\n", GPIO_irqNumber);
+
+   // An alarm that fired before the IRQ is in place holds INT low and sends no further edge
+   DS3231_OpBegin(DS3231_OP_INIT);
+   status = ds3231_get_status(&ds3231_cache.tr, &st);
+   DS3231_OpEnd();
+   if (status < 0)
+     pr_err("DS3231: cannot read status register: %d\n", status);
+
+   ret = request_irq(GPIO_irqNumber,                   //IRQ number
+                     ds3231_irq_handler,               //IRQ handler
+                     IRQF_TRIGGER_FALLING,             //Handler will be called in raising edge
+                     "ds3231_int",                     //used to identify the device name using this IRQ
+                     NULL);                            //device id for shared IRQ
+   if (ret) {
+     pr_err("my_device: cannot register IRQ ");
+     goto r_gpio_in;
+   }
+    pr_info("GPIO IRQ set");
+    if (status >= 0 && (st.status & RTC_STAT_BIT_A1F))
+        queue_work(ds3231_wq, &ds3231_work);
+
+    // Count the square wave from now on, the time written at probe anchors the count
+    if (hires_rate) {
+        DS3231_OpBegin(DS3231_OP_HIRES_RATE);
+        if (ds3231_hr_set_rate(hires_rate) < 0) {
+            pr_err("DS3231: cannot count the square wave at %u Hz, alarms stay on the interrupt\n", hires_rate);
+            hires_rate = 0;
+        }
+        DS3231_OpEnd();
+    }
+
+    // pr_info("Init Over");
+    pr_info("DS3231 Driver Added!!!\n");
+    
+    return ret;
+r_gpio_in:
+         if (alarm_irq < 0)
+             gpio_free(alarm_gpio);
+r_gpio:
+    // Undo the drift ring, the netlink family and the workqueue, in the order ds3231_exit does
+    ds3231_drift_exit();
+    flush_workqueue(ds3231_wq);
+    if (ds3231_genl_registered) {
+        genl_unregister_family(&ds3231_genl_family);
+        ds3231_genl_registered = false;
+    }
+    cancel_work_sync(&ds3231_fanout_work);
+    destroy_workqueue(ds3231_wq);
+    ds3231_wq = NULL;
+r_wq:
+    if (rtc_i2c_client) {
+        i2c_unregister_device(rtc_i2c_client);
+        i2c_del_driver(&ds3231_driver);
+    }
+    proc_remove(rtc_proc_file);
+r_proc:
+    sysfs_remove_file(kobj_ref, &rtc_attr.attr);
+    sysfs_remove_file(kobj_ref, &alarm_attr.attr);
+    sysfs_remove_file(kobj_ref, &stats_attr.attr);
+    sysfs_remove_file(kobj_ref, &alarm_mode_attr.attr);
+    sysfs_remove_file(kobj_ref, &alarm_at_attr.attr);
+    sysfs_remove_file(kobj_ref, &hires_attr.attr);
+    sysfs_remove_file(kobj_ref, &irq_latency_attr.attr);
+    sysfs_remove_file(kobj_ref, &budgets_attr.attr);
+    kobject_put(kobj_ref);
+r_sysfs:
+    device_destroy(dev_class, dev);
+r_device:
+	class_destroy(dev_class);
+r_class:
+	cdev_del(&etx_cdev);
+r_cdev:
+	unregister_chrdev_region(dev,1);
+	return ret;
+
+}
+
+static void __exit ds3231_exit(void)
+{
+    // Remove the proc file entry created for RTC. This and the sysfs files go first, removal
+    // waits for the handlers running, and none can then reprogram the chip behind the
+    // teardown below or reach the client once it is gone.
+    proc_remove(rtc_proc_file);
+    
+    // Remove the sysfs files associated with the RTC and alarm attributes
+    sysfs_remove_file(kobj_ref, &rtc_attr.attr);
+    sysfs_remove_file(kobj_ref, &alarm_attr.attr);
+    sysfs_remove_file(kobj_ref, &stats_attr.attr);
+    sysfs_remove_file(kobj_ref, &alarm_mode_attr.attr);
+    sysfs_remove_file(kobj_ref, &alarm_at_attr.attr);
+    sysfs_remove_file(kobj_ref, &hires_attr.attr);
+    sysfs_remove_file(kobj_ref, &irq_latency_attr.attr);
+    sysfs_remove_file(kobj_ref, &budgets_attr.attr);
+    
+    // Put the alarm back on INT/SQW for whoever uses the chip next
+    ds3231_hr_stop();
+
+    // Free the IRQ associated with the GPIO pin used for DS3231 alarm
+    free_irq(GPIO_irqNumber, NULL);
+
+    // Free the GPIO pin used for DS3231 alarm
+    if (alarm_irq < 0)
+        gpio_free(alarm_gpio);
+    
+    // Stop the drift sampler and free its ring buffer
+    ds3231_drift_exit();
+
+    // Stop broadcasting events, the workqueue below is drained first
+    flush_workqueue(ds3231_wq);
+    if (ds3231_genl_registered)
+        genl_unregister_family(&ds3231_genl_family);
+    // No file is open any more, but the last fan-out may still be queued
+    cancel_work_sync(&ds3231_fanout_work);
+
+    // Destroy the workqueue created for DS3231 operations
+    destroy_workqueue(ds3231_wq);    
+    
+    // Unregister the I2C device driver for DS3231
+    i2c_unregister_device(rtc_i2c_client);
+    
+    // Delete the I2C driver structure for DS3231
+    i2c_del_driver(&ds3231_driver);
+    
+    // Decrement the reference count of the kobject and possibly free it
+    kobject_put(kobj_ref);
+    
+    // Destroy the device node associated with the class and the device class itself
+    device_destroy(dev_class,dev);
+    class_destroy(dev_class);
+    
+    // Delete the character device structure
+    cdev_del(&etx_cdev);
+    
+    // Unregister the allocated character device region
+    unregister_chrdev_region(dev, 1);
+    pr_info("DS3231 Driver Removed!!!\n");
+}
+
+
+module_init(ds3231_init);
+module_exit(ds3231_exit);
+
+MODULE_LICENSE("GPL");
+MODULE_AUTHOR("Viral patel");
+MODULE_DESCRIPTION("DS3231-RTC Driver");
+MODULE_VERSION("1.0");
+
@@ -0,0 +1,560 @@
+#include <linux/module.h>
+#include <linux/init.h>
+#include <linux/kernel.h>
+#include <linux/i2c.h>
+#include <linux/delay.h>
+#include <linux/hrtimer.h>
+#include <linux/ktime.h>
+#include <linux/spinlock.h>
+#include <linux/workqueue.h>
+#include <linux/gpio.h>
+#include <linux/time.h>
+#include <linux/bcd.h>
+#include <linux/kobject.h>
+#include <linux/sysfs.h>
+
+/*
+ * Software model of the DS3231 RTC. It registers a virtual I2C bus with a
+ * DS3231 at 0x68 so that rtc.ko binds to it unchanged, and models the full
+ * register file: ticking time/date, both alarms with A1F/A2F, control and
+ * status, aging offset and temperature. Bus speed and per-transaction
+ * latency are module parameters so slow and fast buses can be compared on
+ * any Linux box.
+ */
+
+#define SIM_NAME            "ds3231_sim"
+#define SIM_SLAVE_ADDR      (0x68)
+#define SIM_NR_REGS         (0x13)
+
+#define SIM_SEC_REG         (0x00)
+#define SIM_MIN_REG         (0x01)
+#define SIM_HR_REG          (0x02)
+#define SIM_DAY_REG         (0x03)
+#define SIM_DATE_REG        (0x04)
+#define SIM_MON_REG         (0x05)
+#define SIM_YR_REG          (0x06)
+#define SIM_ALM1_REG        (0x07)
+#define SIM_ALM2_REG        (0x0B)
+#define SIM_CTL_REG         (0x0E)
+#define SIM_STAT_REG        (0x0F)
+#define SIM_AGING_REG       (0x10)
+#define SIM_TEMP_MSB_REG    (0x11)
+#define SIM_TEMP_LSB_REG    (0x12)
+
+#define SIM_HR_BIT_12H      (0x40)
+#define SIM_HR_BIT_PM       (0x20)
+#define SIM_MON_BIT_CENTURY (0x80)
+#define SIM_ALM_BIT_MASK    (0x80)
+#define SIM_ALM_BIT_DY      (0x40)
+
+#define SIM_CTL_BIT_A1IE    (0x01)
+#define SIM_CTL_BIT_A2IE    (0x02)
+#define SIM_CTL_BIT_INTCN   (0x04)
+#define SIM_CTL_BIT_RS1     (0x08)
+#define SIM_CTL_BIT_RS2     (0x10)
+#define SIM_CTL_BIT_CONV    (0x20)
+
+#define SIM_STAT_BIT_A1F    (0x01)
+#define SIM_STAT_BIT_A2F    (0x02)
+#define SIM_STAT_BIT_BSY    (0x04)
+#define SIM_STAT_BIT_EN32K  (0x08)
+#define SIM_STAT_BIT_OSF    (0x80)
+// Status bits that can only be cleared by the host, never set
+#define SIM_STAT_CLEAR_ONLY (SIM_STAT_BIT_OSF | SIM_STAT_BIT_A2F | SIM_STAT_BIT_A1F)
+
+// The chip runs a temperature conversion every 64 seconds
+#define SIM_TEMP_CONV_SECS  (64)
+
+static int bus_nr = 2;
+module_param(bus_nr, int, 0444);
+MODULE_PARM_DESC(bus_nr, "I2C bus number to register the simulated DS3231 on (default 2)");
+
+static unsigned int bus_khz = 100;
+module_param(bus_khz, uint, 0644);
+MODULE_PARM_DESC(bus_khz, "Simulated SCL frequency in kHz, e.g. 100 or 400 (default 100)");
+
+static unsigned int xfer_latency_us;
+module_param(xfer_latency_us, uint, 0644);
+MODULE_PARM_DESC(xfer_latency_us, "Extra fixed latency added to every I2C transaction in microseconds");
+
+static int int_gpio = -1;
+module_param(int_gpio, int, 0444);
+MODULE_PARM_DESC(int_gpio, "GPIO driven as the active-low INT/SQW output, -1 to disable");
+
+static int temp_mc = 25000;
+module_param(temp_mc, int, 0644);
+MODULE_PARM_DESC(temp_mc, "Die temperature reported by the model in milli-degrees Celsius");
+
+struct ds3231_sim {
+    struct i2c_adapter adap;
+    struct hrtimer tick;
+    struct work_struct int_work;
+    spinlock_t lock;
+
+    u8 regs[SIM_NR_REGS];
+    u8 ptr;
+    bool int_asserted;
+    unsigned int temp_countdown;
+
+    // Statistics
+    unsigned long xfers, bytes, ticks;
+    unsigned long alarm1_hits, alarm2_hits;
+    unsigned long a1f_injected;
+};
+
+static struct ds3231_sim sim;
+static struct kobject *sim_kobj;
+
+static const unsigned char sim_days_in_month[12] = {
+    31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31
+};
+
+// Convert the hour register to 0-23 in either 12 or 24 hour mode
+static unsigned int sim_hour_to_24(u8 reg)
+{
+    unsigned int hour;
+
+    if (!(reg & SIM_HR_BIT_12H))
+        return bcd2bin(reg & 0x3F);
+
+    hour = bcd2bin(reg & 0x1F) % 12;
+    if (reg & SIM_HR_BIT_PM)
+        hour += 12;
+    return hour;
+}
+
+// Encode a 0-23 hour keeping the 12/24 hour mode of the old register value
+static u8 sim_hour_from_24(unsigned int hour, u8 old)
+{
+    unsigned int h12;
+
+    if (!(old & SIM_HR_BIT_12H))
+        return bin2bcd(hour);
+
+    h12 = hour % 12 ? hour % 12 : 12;
+    return SIM_HR_BIT_12H | (hour >= 12 ? SIM_HR_BIT_PM : 0) | bin2bcd(h12);
+}
+
+// Refresh the temperature registers from temp_mc (10-bit, 0.25 C steps)
+static void sim_update_temp(void)
+{
+    int quarters = DIV_ROUND_CLOSEST(temp_mc, 250);
+
+    sim.regs[SIM_TEMP_MSB_REG] = (u8)(s8)(quarters >> 2);
+    sim.regs[SIM_TEMP_LSB_REG] = (quarters & 0x03) << 6;
+}
+
+// Evaluate the INT output, returns true if its level changed
+static bool sim_update_int(void)
+{
+    u8 ctl = sim.regs[SIM_CTL_REG];
+    u8 stat = sim.regs[SIM_STAT_REG];
+    bool asserted;
+
+    asserted = (ctl & SIM_CTL_BIT_INTCN) &&
+               (((ctl & SIM_CTL_BIT_A1IE) && (stat & SIM_STAT_BIT_A1F)) ||
+                ((ctl & SIM_CTL_BIT_A2IE) && (stat & SIM_STAT_BIT_A2F)));
+
+    if (asserted == sim.int_asserted)
+        return false;
+    sim.int_asserted = asserted;
+    return true;
+}
+
+// Check one day/date alarm register against the current calendar
+static bool sim_match_day_date(u8 alm, unsigned int day, unsigned int date)
+{
+    if (alm & SIM_ALM_BIT_MASK)
+        return true;
+    if (alm & SIM_ALM_BIT_DY)
+        return bcd2bin(alm & 0x0F) == day;
+    return bcd2bin(alm & 0x3F) == date;
+}
+
+static void sim_check_alarms(unsigned int sec, unsigned int min, unsigned int hour,
+                             unsigned int day, unsigned int date)
+{
+    const u8 *a1 = &sim.regs[SIM_ALM1_REG];
+    const u8 *a2 = &sim.regs[SIM_ALM2_REG];
+
+    if (((a1[0] & SIM_ALM_BIT_MASK) || bcd2bin(a1[0] & 0x7F) == sec) &&
+        ((a1[1] & SIM_ALM_BIT_MASK) || bcd2bin(a1[1] & 0x7F) == min) &&
+        ((a1[2] & SIM_ALM_BIT_MASK) || sim_hour_to_24(a1[2] & 0x7F) == hour) &&
+        sim_match_day_date(a1[3], day, date)) {
+        sim.regs[SIM_STAT_REG] |= SIM_STAT_BIT_A1F;
+        sim.alarm1_hits++;
+    }
+
+    // Alarm 2 has no seconds register and is evaluated at second 00
+    if (sec == 0 &&
+        ((a2[0] & SIM_ALM_BIT_MASK) || bcd2bin(a2[0] & 0x7F) == min) &&
+        ((a2[1] & SIM_ALM_BIT_MASK) || sim_hour_to_24(a2[1] & 0x7F) == hour) &&
+        sim_match_day_date(a2[2], day, date)) {
+        sim.regs[SIM_STAT_REG] |= SIM_STAT_BIT_A2F;
+        sim.alarm2_hits++;
+    }
+}
+
+// Advance the time registers by one second with full calendar rollover
+static void sim_advance_second(void)
+{
+    u8 *r = sim.regs;
+    unsigned int sec = bcd2bin(r[SIM_SEC_REG] & 0x7F);
+    unsigned int min = bcd2bin(r[SIM_MIN_REG] & 0x7F);
+    unsigned int hour = sim_hour_to_24(r[SIM_HR_REG]);
+    unsigned int day = bcd2bin(r[SIM_DAY_REG] & 0x07);
+    unsigned int date = bcd2bin(r[SIM_DATE_REG] & 0x3F);
+    unsigned int month = bcd2bin(r[SIM_MON_REG] & 0x1F);
+    unsigned int year = bcd2bin(r[SIM_YR_REG]);
+    u8 century = r[SIM_MON_REG] & SIM_MON_BIT_CENTURY;
+    unsigned int mdays;
+
+    if (++sec < 60)
+        goto out;
+    sec = 0;
+    if (++min < 60)
+        goto out;
+    min = 0;
+    if (++hour < 24)
+        goto out;
+    hour = 0;
+
+    day = day >= 7 ? 1 : day + 1;
+    mdays = (month >= 1 && month <= 12) ? sim_days_in_month[month - 1] : 31;
+    if (month == 2 && year % 4 == 0)
+        mdays = 29;
+    if (++date <= mdays)
+        goto out;
+    date = 1;
+    if (++month <= 12)
+        goto out;
+    month = 1;
+    if (++year < 100)
+        goto out;
+    year = 0;
+    century ^= SIM_MON_BIT_CENTURY;
+
+out:
+    r[SIM_SEC_REG] = bin2bcd(sec);
+    r[SIM_MIN_REG] = bin2bcd(min);
+    r[SIM_HR_REG] = sim_hour_from_24(hour, r[SIM_HR_REG]);
+    r[SIM_DAY_REG] = bin2bcd(day);
+    r[SIM_DATE_REG] = bin2bcd(date);
+    r[SIM_MON_REG] = century | bin2bcd(month);
+    r[SIM_YR_REG] = bin2bcd(year);
+
+    sim_check_alarms(sec, min, hour, day, date);
+}
+
+// One second period corrected by the aging offset (about 0.1 ppm per LSB)
+static ktime_t sim_tick_period(void)
+{
+    s8 aging = (s8)sim.regs[SIM_AGING_REG];
+
+    return ns_to_ktime(NSEC_PER_SEC + (s64)aging * 100);
+}
+
+static enum hrtimer_restart sim_tick_fn(struct hrtimer *timer)
+{
+    unsigned long flags;
+    bool int_changed;
+
+    spin_lock_irqsave(&sim.lock, flags);
+    sim_advance_second();
+    sim.ticks++;
+    if (--sim.temp_countdown == 0) {
+        sim.temp_countdown = SIM_TEMP_CONV_SECS;
+        sim_update_temp();
+    }
+    int_changed = sim_update_int();
+    spin_unlock_irqrestore(&sim.lock, flags);
+
+    if (int_changed)
+        schedule_work(&sim.int_work);
+
+    hrtimer_forward_now(timer, sim_tick_period());
+    return HRTIMER_RESTART;
+}
+
+// Drive the INT/SQW GPIO from process context, the line may sleep
+static void sim_int_work_fn(struct work_struct *work)
+{
+    bool asserted = READ_ONCE(sim.int_asserted);
+
+    if (int_gpio >= 0)
+        gpio_set_value_cansleep(int_gpio, asserted ? 0 : 1);
+}
+
+// Apply a host write to one register, honouring read-only and clear-only bits
+static void sim_write_reg(u8 reg, u8 val)
+{
+    switch (reg) {
+    case SIM_STAT_REG:
+        sim.regs[reg] = (sim.regs[reg] & val & SIM_STAT_CLEAR_ONLY) |
+                        (val & SIM_STAT_BIT_EN32K) |
+                        (sim.regs[reg] & SIM_STAT_BIT_BSY);
+        break;
+    case SIM_CTL_REG:
+        // A conversion completes immediately in the model
+        if (val & SIM_CTL_BIT_CONV)
+            sim_update_temp();
+        sim.regs[reg] = val & ~SIM_CTL_BIT_CONV;
+        break;
+    case SIM_TEMP_MSB_REG:
+    case SIM_TEMP_LSB_REG:
+        break;
+    default:
+        sim.regs[reg] = val;
+        break;
+    }
+}
+
+// Time spent on the wire for one message at the configured bus speed
+static unsigned long sim_msg_time_ns(const struct i2c_msg *msg)
+{
+    unsigned int khz = bus_khz ? bus_khz : 100;
+    // START, address byte, data bytes (8 bits + ACK each) and STOP
+    unsigned long bits = 2 + 9 * (1 + (unsigned long)msg->len);
+
+    return bits * 1000000UL / khz;
+}
+
+static void sim_delay_ns(unsigned long ns)
+{
+    unsigned long us = DIV_ROUND_UP(ns, 1000);
+
+    if (us >= 10)
+        usleep_range(us, us + us / 8 + 1);
+    else if (us)
+        udelay(us);
+}
+
+static int sim_master_xfer(struct i2c_adapter *adap, struct i2c_msg *msgs, int num)
+{
+    unsigned long flags, wire_ns = 0;
+    bool restart_tick = false;
+    bool int_changed;
+    int i, j;
+
+    for (i = 0; i < num; i++) {
+        if (msgs[i].addr != SIM_SLAVE_ADDR)
+            return -ENXIO;
+        wire_ns += sim_msg_time_ns(&msgs[i]);
+    }
+
+    spin_lock_irqsave(&sim.lock, flags);
+    for (i = 0; i < num; i++) {
+        struct i2c_msg *msg = &msgs[i];
+
+        if (msg->flags & I2C_M_RD) {
+            for (j = 0; j < msg->len; j++) {
+                msg->buf[j] = sim.regs[sim.ptr];
+                sim.ptr = (sim.ptr + 1) % SIM_NR_REGS;
+            }
+        } else if (msg->len) {
+            // First byte sets the register pointer, the rest are data
+            sim.ptr = msg->buf[0] < SIM_NR_REGS ? msg->buf[0] : 0;
+            for (j = 1; j < msg->len; j++) {
+                // Writing seconds resets the countdown chain
+                if (sim.ptr == SIM_SEC_REG)
+                    restart_tick = true;
+                sim_write_reg(sim.ptr, msg->buf[j]);
+                sim.ptr = (sim.ptr + 1) % SIM_NR_REGS;
+            }
+        }
+        sim.xfers++;
+        sim.bytes += 1 + msg->len;
+    }
+    int_changed = sim_update_int();
+    spin_unlock_irqrestore(&sim.lock, flags);
+
+    if (restart_tick)
+        hrtimer_start(&sim.tick, sim_tick_period(), HRTIMER_MODE_REL);
+    if (int_changed)
+        schedule_work(&sim.int_work);
+
+    sim_delay_ns(wire_ns + (unsigned long)xfer_latency_us * 1000);
+
+    return num;
+}
+
+static u32 sim_functionality(struct i2c_adapter *adap)
+{
+    return I2C_FUNC_I2C | I2C_FUNC_SMBUS_EMUL;
+}
+
+static const struct i2c_algorithm sim_algo = {
+    .master_xfer    = sim_master_xfer,
+    .functionality  = sim_functionality,
+};
+
+// Power-on state: time from the system clock, OSF set as after a cold start
+static void sim_reset_regs(void)
+{
+    struct timespec64 ts;
+    struct tm tm;
+
+    ktime_get_real_ts64(&ts);
+    time64_to_tm(ts.tv_sec, 0, &tm);
+
+    memset(sim.regs, 0, sizeof(sim.regs));
+    sim.regs[SIM_SEC_REG] = bin2bcd(tm.tm_sec);
+    sim.regs[SIM_MIN_REG] = bin2bcd(tm.tm_min);
+    sim.regs[SIM_HR_REG] = bin2bcd(tm.tm_hour);
+    sim.regs[SIM_DAY_REG] = bin2bcd(tm.tm_wday + 1);
+    sim.regs[SIM_DATE_REG] = bin2bcd(tm.tm_mday);
+    sim.regs[SIM_MON_REG] = bin2bcd(tm.tm_mon + 1);
+    sim.regs[SIM_YR_REG] = bin2bcd(tm.tm_year % 100);
+    sim.regs[SIM_CTL_REG] = SIM_CTL_BIT_INTCN | SIM_CTL_BIT_RS1 | SIM_CTL_BIT_RS2;
+    sim.regs[SIM_STAT_REG] = SIM_STAT_BIT_OSF | SIM_STAT_BIT_EN32K;
+    sim_update_temp();
+    sim.temp_countdown = SIM_TEMP_CONV_SECS;
+}
+
+/* sysfs start */
+static ssize_t regs_show(struct kobject *kobj, struct kobj_attribute *attr, char *buf)
+{
+    u8 regs[SIM_NR_REGS];
+    unsigned long flags;
+    int len = 0;
+    int i;
+
+    spin_lock_irqsave(&sim.lock, flags);
+    memcpy(regs, sim.regs, sizeof(regs));
+    spin_unlock_irqrestore(&sim.lock, flags);
+
+    for (i = 0; i < SIM_NR_REGS; i++)
+        len += sprintf(buf + len, "%02x%c", regs[i], i == SIM_NR_REGS - 1 ? '\n' : ' ');
+    return len;
+}
+
+static ssize_t int_show(struct kobject *kobj, struct kobj_attribute *attr, char *buf)
+{
+    return sprintf(buf, "%d\n", READ_ONCE(sim.int_asserted));
+}
+
+static ssize_t stats_show(struct kobject *kobj, struct kobj_attribute *attr, char *buf)
+{
+    unsigned long flags;
+    int len;
+
+    spin_lock_irqsave(&sim.lock, flags);
+    len = sprintf(buf, "xfers: %lu\nbytes: %lu\nticks: %lu\nalarm1_hits: %lu\nalarm2_hits: %lu\na1f_injected: %lu\n",
+                  sim.xfers, sim.bytes, sim.ticks, sim.alarm1_hits, sim.alarm2_hits, sim.a1f_injected);
+    spin_unlock_irqrestore(&sim.lock, flags);
+    return len;
+}
+
+// Set A1F as if alarm 1 had matched, for driving the alarm path at any rate. INT follows as for
+// a real match, or the edge comes from elsewhere, e.g. a gpio-sim line the driver listens on.
+static ssize_t inject_a1f_store(struct kobject *kobj, struct kobj_attribute *attr,
+                                const char *buf, size_t count)
+{
+    unsigned long flags;
+    bool int_changed;
+
+    if (!sysfs_streq(buf, "1"))
+        return -EINVAL;
+
+    spin_lock_irqsave(&sim.lock, flags);
+    sim.regs[SIM_STAT_REG] |= SIM_STAT_BIT_A1F;
+    sim.a1f_injected++;
+    int_changed = sim_update_int();
+    spin_unlock_irqrestore(&sim.lock, flags);
+
+    if (int_changed)
+        schedule_work(&sim.int_work);
+    return count;
+}
+
+static struct kobj_attribute sim_regs_attr = __ATTR_RO(regs);
+static struct kobj_attribute sim_int_attr = __ATTR_RO(int);
+static struct kobj_attribute sim_stats_attr = __ATTR_RO(stats);
+static struct kobj_attribute sim_inject_a1f_attr = __ATTR_WO(inject_a1f);
+
+static struct attribute *sim_attrs[] = {
+    &sim_regs_attr.attr,
+    &sim_int_attr.attr,
+    &sim_stats_attr.attr,
+    &sim_inject_a1f_attr.attr,
+    NULL,
+};
+
+static const struct attribute_group sim_attr_group = {
+    .attrs = sim_attrs,
+};
+/* sysfs end */
+
+static int __init ds3231_sim_init(void)
+{
+    int ret;
+
+    spin_lock_init(&sim.lock);
+    INIT_WORK(&sim.int_work, sim_int_work_fn);
+    sim_reset_regs();
+
+    if (int_gpio >= 0) {
+        ret = gpio_request_one(int_gpio, GPIOF_OUT_INIT_HIGH, "ds3231_sim_int");
+        if (ret) {
+            pr_err("ds3231_sim: cannot request INT GPIO %d\n", int_gpio);
+            return ret;
+        }
+    }
+
+    sim.adap.owner = THIS_MODULE;
+    sim.adap.algo = &sim_algo;
+    sim.adap.nr = bus_nr;
+    strlcpy(sim.adap.name, SIM_NAME, sizeof(sim.adap.name));
+
+    ret = i2c_add_numbered_adapter(&sim.adap);
+    if (ret) {
+        pr_err("ds3231_sim: cannot register I2C bus %d\n", bus_nr);
+        goto r_gpio;
+    }
+
+    sim_kobj = kobject_create_and_add(SIM_NAME, kernel_kobj);
+    if (!sim_kobj) {
+        ret = -ENOMEM;
+        goto r_adap;
+    }
+    ret = sysfs_create_group(sim_kobj, &sim_attr_group);
+    if (ret)
+        goto r_kobj;
+
+    hrtimer_init(&sim.tick, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+    sim.tick.function = sim_tick_fn;
+    hrtimer_start(&sim.tick, sim_tick_period(), HRTIMER_MODE_REL);
+
+    pr_info("ds3231_sim: DS3231 model on I2C bus %d at 0x%02x, %u kHz\n",
+            bus_nr, SIM_SLAVE_ADDR, bus_khz);
+    return 0;
+
+r_kobj:
+    kobject_put(sim_kobj);
+r_adap:
+    i2c_del_adapter(&sim.adap);
+r_gpio:
+    if (int_gpio >= 0)
+        gpio_free(int_gpio);
+    return ret;
+}
+
+static void __exit ds3231_sim_exit(void)
+{
+    hrtimer_cancel(&sim.tick);
+    cancel_work_sync(&sim.int_work);
+    sysfs_remove_group(sim_kobj, &sim_attr_group);
+    kobject_put(sim_kobj);
+    i2c_del_adapter(&sim.adap);
+    if (int_gpio >= 0)
+        gpio_free(int_gpio);
+    pr_info("ds3231_sim: removed\n");
+}
+
+module_init(ds3231_sim_init);
+module_exit(ds3231_sim_exit);
+
+MODULE_LICENSE("GPL");
+MODULE_AUTHOR("Viral patel");
+MODULE_DESCRIPTION("Software DS3231 RTC model on a virtual I2C bus");
+MODULE_VERSION("1.0");